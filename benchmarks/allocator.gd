@@ -0,0 +1,81 @@
+# Allocation counts and time of the spine allocator for spawn, play, mix and
+# draw (clipping) workloads, then the pool memory trimmed once the nodes are
+# freed. spine/memory/allocator needs a restart, so run
+# the script once per mode with an override.cfg in the project folder:
+#
+#   [spine]
+#   memory/allocator=1
+#
+# --skeleton=<path>    skeleton resource (required); use one with clipping
+#                      attachments to exercise SkeletonClipping in draw
+# --count=<n>          Spine nodes (100)
+# --steps=<n>          process steps for play and mix, frames for draw (120)
+extends SceneTree
+
+const Common = preload("common.gd")
+
+var nodes = []
+var steps = 0
+var frames = 0
+var phase_start = 0
+
+
+func _begin():
+	SpineMemory.reset_allocator_stats()
+	phase_start = OS.get_ticks_usec()
+
+
+func _end(name):
+	var usec = OS.get_ticks_usec() - phase_start
+	var stats = SpineMemory.get_allocator_stats()
+	var allocs = stats["heap_allocs"] + stats["pool_allocs"] + stats["arena_allocs"]
+	print("%s: %d us, %d allocs (heap %d, pool %d, arena %d), %d frees" % [
+			name, usec, allocs, stats["heap_allocs"], stats["pool_allocs"], stats["arena_allocs"], stats["frees"]])
+
+
+func _init():
+	var resource = Common.load_arg(self, "skeleton")
+	if resource == null:
+		return
+	var count = int(Common.arg("count", 100))
+	steps = int(Common.arg("steps", 120))
+	var animations = resource.get_animation_names()
+	print("allocator mode: %d" % SpineMemory.get_allocator_mode())
+
+	_begin()
+	for i in range(count):
+		var spine = Spine.new()
+		spine.resource = resource
+		spine.position = Vector2(i % 10, i / 10) * 64
+		root.add_child(spine)
+		spine.play(animations[0], 1.0, true)
+		nodes.append(spine)
+	_end("spawn")
+
+	_begin()
+	for s in range(steps):
+		for spine in nodes:
+			spine._animation_process(1.0 / 60)
+	_end("play")
+
+	resource.default_mix = 0.2
+	_begin()
+	for s in range(steps):
+		for spine in nodes:
+			if s % 10 == 0:
+				spine.play(animations[(s / 10) % animations.size()], 1.0, true)
+			spine._animation_process(1.0 / 60)
+	_end("mix")
+	_begin()
+
+
+func _idle(_delta):
+	frames += 1
+	if frames < steps:
+		return
+	_end("draw")
+	for spine in nodes:
+		spine.free()
+	var reserved = SpineMemory.get_allocator_stats()["pool_reserved"]
+	print("trim: %d of %d pool bytes released" % [SpineMemory.trim_allocator_pools(), reserved])
+	quit()
@@ -0,0 +1,56 @@
+# Time to override bones through `bone/<name>/rotation` and `bone/<name>/position`
+# properties against a single set_bones_local() call, followed by the world
+# transform read that forces the pose update.
+#
+# --skeleton=<path>    skeleton resource (required)
+# --bones=<n>          bones to edit per iteration (50)
+# --iterations=<n>     iterations per case (1000)
+extends SceneTree
+
+const Common = preload("common.gd")
+
+
+func _init():
+	var resource = Common.load_arg(self, "skeleton")
+	if resource == null:
+		return
+	var bones = int(Common.arg("bones", 50))
+	var iterations = int(Common.arg("iterations", 1000))
+
+	var spine = Spine.new()
+	spine.resource = resource
+	root.add_child(spine)
+
+	# property names are built up front so only the set() calls are timed
+	var rotation_properties = []
+	var position_properties = []
+	var ids = PoolIntArray()
+	var positions = PoolVector2Array()
+	var rotations = PoolRealArray()
+	var skeleton_bones = spine.get_skeleton()["bones"]
+	for i in range(bones):
+		var id = i % skeleton_bones.size()
+		rotation_properties.append("bone/%s/rotation" % skeleton_bones[id]["name"])
+		position_properties.append("bone/%s/position" % skeleton_bones[id]["name"])
+		ids.append(id)
+		positions.append(Vector2(i, -i))
+		rotations.append(i * 3.0)
+
+	var start = OS.get_ticks_usec()
+	for n in range(iterations):
+		for i in range(bones):
+			spine.set(rotation_properties[i], rotations[i])
+			spine.set(position_properties[i], positions[i])
+		spine.get_bone_world_by_id(ids[bones - 1])
+	var properties_usec = OS.get_ticks_usec() - start
+
+	start = OS.get_ticks_usec()
+	for n in range(iterations):
+		spine.set_bones_local(ids, positions, rotations)
+		spine.get_bone_world_by_id(ids[bones - 1])
+	var bulk_usec = OS.get_ticks_usec() - start
+
+	print("properties: %.2f us per %d bones" % [float(properties_usec) / iterations, bones])
+	print("set_bones_local: %.2f us per %d bones" % [float(bulk_usec) / iterations, bones])
+	spine.free()
+	quit()
@@ -0,0 +1,31 @@
+# Option parsing shared by the benchmark scripts, which load it with
+#
+#   const Common = preload("common.gd")
+extends Reference
+
+
+static func arg(name, default):
+	for a in OS.get_cmdline_args():
+		if a.begins_with("--%s=" % name):
+			return a.split("=", true, 1)[1]
+	return default
+
+
+# The resource at --<name>=<path>, or null once the missing option is
+# reported and the tree quits with an error.
+static func load_arg(tree, name):
+	var resource = load(arg(name, ""))
+	if resource == null:
+		printerr("--%s=<path> is required" % name)
+		tree.quit(1)
+	return resource
+
+
+# The paths of --<name>=<a,b,...>, or none once the missing option is
+# reported and the tree quits with an error.
+static func paths_arg(tree, name):
+	var paths = Array(arg(name, "").split(",", false))
+	if paths.empty():
+		printerr("--%s=<a,b,...> is required" % name)
+		tree.quit(1)
+	return paths
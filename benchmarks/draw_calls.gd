@@ -0,0 +1,73 @@
+# Draw calls and frame time of on-screen Spine nodes per skeleton. Pass a
+# skeleton and its import cooked with atlas/merge_pages on (the .spinec
+# under res://.import) to compare before and after merging:
+#
+#   --skeletons=res://hero.skel,res://.import/hero.skel-<hash>.spinec
+#
+# --skeletons=<a,b,...>  skeleton paths (required)
+# --animation=<name>     animation to play (the first one)
+# --count=<n>            Spine nodes per skeleton (20)
+# --frames=<n>           measured frames per skeleton (120)
+extends SceneTree
+
+const Common = preload("common.gd")
+
+var paths = []
+var count = 0
+var frames = 0
+var scene = null
+var frame = 0
+var draw_calls = 0
+var frame_start = 0
+
+
+func _init():
+	paths = Common.paths_arg(self, "skeletons")
+	if paths.empty():
+		return
+	count = int(Common.arg("count", 20))
+	frames = int(Common.arg("frames", 120))
+
+
+func _start(path):
+	var resource = ResourceLoader.load(path, "", true)
+	if resource == null:
+		printerr("can't load " + path)
+		return false
+	scene = Node2D.new()
+	for i in range(count):
+		var spine = Spine.new()
+		spine.resource = resource
+		spine.position = Vector2(64 + (i % 5) * 128, 64 + (i / 5) * 128)
+		scene.add_child(spine)
+		var animation = Common.arg("animation", "")
+		if animation == "" and not spine.get_animation_names().empty():
+			animation = spine.get_animation_names()[0]
+		spine.play(animation, 1.0, true)
+	root.add_child(scene)
+	frame = 0
+	draw_calls = 0
+	return true
+
+
+func _idle(_delta):
+	if scene == null:
+		while not paths.empty() and not _start(paths[0]):
+			paths.pop_front()
+		if paths.empty():
+			quit()
+		return
+	frame += 1
+	if frame == 2:
+		# the first frames load pages and create runtimes
+		frame_start = OS.get_ticks_usec()
+	elif frame > 2:
+		for spine in scene.get_children():
+			draw_calls += spine.get("performance/draw_calls")
+	if frame < frames + 2:
+		return
+	print("%s: %.2f draw calls per node, %.2f ms per frame" % [
+			paths[0], float(draw_calls) / (count * frames), (OS.get_ticks_usec() - frame_start) / 1000.0 / frames])
+	scene.free()
+	scene = null
+	paths.pop_front()
@@ -0,0 +1,49 @@
+# Scene instantiation cost of many Spine nodes, and of the first frame that
+# draws them. With --visible=0 every node is placed far off-screen and
+# should never create its runtime.
+#
+# --skeleton=<path>    skeleton resource (required)
+# --count=<n>          nodes to instantiate (500)
+# --visible=<0|1>      place the nodes on screen (0)
+extends SceneTree
+
+const Common = preload("common.gd")
+
+var nodes = []
+var frames = 0
+var frame_start = 0
+
+
+func _init():
+	var resource = Common.load_arg(self, "skeleton")
+	if resource == null:
+		return
+	var count = int(Common.arg("count", 500))
+	var offset = Vector2() if int(Common.arg("visible", 0)) else Vector2(1e6, 1e6)
+
+	var scene = Node2D.new()
+	var start = OS.get_ticks_usec()
+	for i in range(count):
+		var spine = Spine.new()
+		spine.resource = resource
+		spine.position = offset + Vector2(i % 32, i / 32) * 16
+		scene.add_child(spine)
+		nodes.append(spine)
+	var instantiate_usec = OS.get_ticks_usec() - start
+
+	start = OS.get_ticks_usec()
+	root.add_child(scene)
+	var enter_tree_usec = OS.get_ticks_usec() - start
+
+	print("instantiate: %d us for %d nodes" % [instantiate_usec, count])
+	print("enter tree: %d us" % enter_tree_usec)
+	frame_start = OS.get_ticks_usec()
+
+
+func _idle(_delta):
+	frames += 1
+	if frames < 2:
+		return
+	print("first frame: %d us" % (OS.get_ticks_usec() - frame_start))
+	print("runtimes created: %d" % nodes[0].resource.get_pool_stats().get("misses", 0))
+	quit()
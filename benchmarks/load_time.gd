@@ -0,0 +1,73 @@
+# Load time of skeleton resources, bypassing the resource cache, with the
+# read and parse split and the memory the spine allocator kept for each
+# resource (needs spine/memory/track_allocations or a pooled allocator mode).
+# Resident and peak resident memory come from /proc/self/status (Linux
+# only); run one path per process when comparing peaks.
+#
+# Imported .skel/.spjson paths load their cooked .spinec and are marked
+# "cooked"; run once with spine/import/cook_skeletons off and once with it on
+# to compare the same skeletons before and after cooking.
+#
+# --skeletons=<a,b,...>  skeleton paths (.json, .spjson, .skel or a .spinec)
+# --iterations=<n>       loads per path (10)
+# --library=<n>          then keep n uncached copies of each path loaded and
+#                        report their memory, e.g. 200 for a library (0)
+extends SceneTree
+
+const Common = preload("common.gd")
+
+
+func _status_kb(field):
+	var f = File.new()
+	if f.open("/proc/self/status", File.READ) != OK:
+		return -1
+	var text = f.get_as_text()
+	f.close()
+	for line in text.split("\n"):
+		if line.begins_with(field + ":"):
+			return int(line.split(":")[1].strip_edges().split(" ")[0])
+	return -1
+
+
+func _init():
+	var paths = Common.paths_arg(self, "skeletons")
+	if paths.empty():
+		return
+	var iterations = int(Common.arg("iterations", 10))
+	for path in paths:
+		var total = 0
+		var read = 0
+		var parse = 0
+		var bytes = 0
+		var memory = 0
+		for i in range(iterations):
+			var start = OS.get_ticks_usec()
+			var resource = ResourceLoader.load(path, "", true)
+			total += OS.get_ticks_usec() - start
+			if resource == null:
+				printerr("can't load " + path)
+				break
+			var stats = resource.get_load_stats()
+			read += stats["read_usec"]
+			parse += stats["parse_usec"]
+			bytes = stats["bytes"]
+			memory = stats["memory"]
+		var label = path + (" (cooked)" if File.new().file_exists(path + ".import") else "")
+		print("%s: %.2f ms per load (read %.2f, parse %.2f), %d bytes, %d kB" % [
+				label, total / 1000.0 / iterations, read / 1000.0 / iterations, parse / 1000.0 / iterations, bytes, memory / 1024])
+	var library = int(Common.arg("library", 0))
+	if library > 0:
+		var kept = []
+		var memory = 0
+		var rss = _status_kb("VmRSS")
+		var start = OS.get_ticks_usec()
+		for path in paths:
+			for i in range(library):
+				var resource = ResourceLoader.load(path, "", true)
+				if resource != null:
+					kept.append(resource)
+					memory += resource.get_load_stats()["memory"]
+		print("library of %d: %.2f ms, %d kB, +%d kB rss" % [
+				kept.size(), (OS.get_ticks_usec() - start) / 1000.0, memory / 1024, _status_kb("VmRSS") - rss])
+	print("rss: %d kB, peak rss: %d kB" % [_status_kb("VmRSS"), _status_kb("VmHWM")])
+	quit()
@@ -34,10 +34,16 @@
 #include "spine.h"
 #include "animation_node_spine.h"
 
+#include "core/engine.h"
 #include "core/os/file_access.h"
 #include "core/os/os.h"
+#include "core/os/thread.h"
+#include "runtime/spine_allocator.h"
 #include "core/io/resource_loader.h"
 #include "scene/resources/texture.h"
+#ifdef TOOLS_ENABLED
+#include "spine_importer.h"
+#endif
 
 typedef Ref<Texture> TextureRef;
 typedef Ref<ImageTexture> ImageTextureRef;
@@ -112,6 +118,90 @@ typedef Ref<ImageTexture> ImageTextureRef;
 // 	memfree(ptr);
 // }
 
+// Loads a skeleton in stages: read the file, fetch the atlas pages, parse
+// atlas and skeleton data, then create one of its queued page textures per poll. Texture stages only run on the main thread; when
+// polled from a worker they are left to the first draw.
+class ResourceInteractiveLoaderSpine : public ResourceInteractiveLoader {
+	enum Stage {
+		STAGE_READ,
+		STAGE_PREFETCH,
+		STAGE_PARSE,
+		STAGE_TEXTURES,
+	};
+
+	String path;
+	String local_path;
+	SpineRuntime::SkeletonSource source;
+	Ref<SpineResource> resource;
+	int stage;
+	int texture_count;
+	bool done;
+
+public:
+	virtual void set_local_path(const String &p_local_path) {
+		local_path = p_local_path;
+	}
+
+	virtual Ref<Resource> get_resource() {
+		return done ? resource : Ref<SpineResource>();
+	}
+
+	virtual Error poll() {
+		if (done) {
+			return ERR_FILE_EOF;
+		}
+		switch (stage) {
+			case STAGE_READ: {
+				Error err = SpineRuntime::read_skeleton(path, source);
+				if (err != OK) {
+					return err;
+				}
+				stage = STAGE_PREFETCH;
+			} break;
+			case STAGE_PREFETCH: {
+				SpineRuntime::prefetch_textures(source);
+				stage = STAGE_PARSE;
+			} break;
+			case STAGE_PARSE: {
+				resource = SpineRuntime::parse_skeleton(source);
+				ERR_FAIL_COND_V(resource.is_null(), ERR_FILE_CORRUPT);
+				SpineRuntime::finish_resource(resource, source.path);
+				source = SpineRuntime::SkeletonSource();
+				texture_count = resource->get_pending_texture_count();
+				stage = STAGE_TEXTURES;
+			} break;
+			default: {
+				if (Thread::get_caller_id() != Thread::get_main_id() || resource->finalize_textures(1) == 0) {
+					if (local_path != String()) {
+						resource->set_path(local_path);
+					}
+					done = true;
+					return ERR_FILE_EOF;
+				}
+			} break;
+		}
+		return OK;
+	}
+
+	virtual int get_stage() const {
+		if (stage < STAGE_TEXTURES) {
+			return stage;
+		}
+		return STAGE_TEXTURES + CLAMP(texture_count - resource->get_pending_texture_count(), 0, texture_count);
+	}
+
+	virtual int get_stage_count() const {
+		return STAGE_TEXTURES + texture_count;
+	}
+
+	ResourceInteractiveLoaderSpine(const String &p_path) {
+		path = p_path;
+		stage = STAGE_READ;
+		texture_count = 0;
+		done = false;
+	}
+};
+
 class ResourceFormatLoaderSpine : public ResourceFormatLoader {
 public:
 
@@ -119,26 +209,43 @@ public:
 		return SpineRuntime::load_resource(p_path);
 	}
 
+	virtual Ref<ResourceInteractiveLoader> load_interactive(const String &p_path, const String &p_original_path = "", Error *r_error = NULL) {
+		if (r_error) {
+			*r_error = OK;
+		}
+		return memnew(ResourceInteractiveLoaderSpine(p_path));
+	}
+
 	virtual void get_recognized_extensions(List<String> *p_extensions) const {
 		p_extensions->push_back("skel");
 		p_extensions->push_back("json");
+		p_extensions->push_back("spjson");
 		p_extensions->push_back("atlas");
+		p_extensions->push_back("spinec");
 	}
 
 	virtual void get_dependencies(const String &p_path, List<String> *p_dependencies, bool p_add_types) {
-		// String base_dir = p_path.get_base_dir();
-		// String base_name = p_path.get_basename();
-		// String atlas_path = base_name + ".atlas";
-		// if (!FileAccess::exists(atlas_path)) return;
-		// p_dependencies->push_back(atlas_path);
-		// Vector<uint8_t> bytes = FileAccess::get_file_as_array(atlas_path);
-		// spAtlas *atlas = spAtlas_create((const char*)bytes.ptr(), bytes.size(), base_dir.utf8(), NULL);
-		// spAtlasPage *page = atlas->pages;
-		// while (page) {
-		// 	p_dependencies->push_back(base_dir + "/" + page->name);
-		// 	page = page->next;
-		// }
-		// spAtlas_dispose(atlas);
+		SpineRuntime::SkeletonSource source;
+		if (p_path.ends_with(".spinec")) {
+			// the atlas itself is embedded
+			if (SpineRuntime::read_cooked(p_path, source) != OK) return;
+		} else if (SpineRuntime::is_json(p_path) || p_path.ends_with(".skel")) {
+			source.path = p_path;
+			source.atlas_path = SpineRuntime::find_atlas_path(p_path);
+			source.atlas_data = SpineRuntime::get_atlas_data(source);
+			if (source.atlas_data.empty()) return;
+			p_dependencies->push_back(source.atlas_path);
+		} else {
+			return;
+		}
+		String mixes_path = source.path.get_basename() + ".mixes";
+		if (FileAccess::exists(mixes_path)) {
+			p_dependencies->push_back(mixes_path);
+		}
+		Vector<String> pages = SpineRuntime::get_atlas_pages(source.atlas_path, source.atlas_data);
+		for (int i = 0; i < pages.size(); i++) {
+			p_dependencies->push_back(p_add_types ? pages[i] + "::Texture" : pages[i]);
+		}
 	}
 
 	virtual bool handles_type(const String& p_type) const {
@@ -149,18 +256,61 @@ public:
 	virtual String get_resource_type(const String &p_path) const {
 
 		String el = p_path.get_extension().to_lower();
-		if (el=="json" || el=="skel")
+		if (el=="json" || el=="spjson" || el=="skel" || el=="spinec")
 			return "SpineResource";
 		return "";
 	}
 };
 
 Ref<ResourceFormatLoaderSpine> resource_loader_spine;
+SpineMemory *spine_memory = NULL;
 
 void register_spine_types() {
 
+	GLOBAL_DEF("spine/pose_cache/memory_limit", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/pose_cache/memory_limit", PropertyInfo(Variant::INT, "spine/pose_cache/memory_limit", PROPERTY_HINT_RANGE, "0,268435456,1024"));
+	GLOBAL_DEF("spine/pose_cache/fps", 60);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/pose_cache/fps", PropertyInfo(Variant::REAL, "spine/pose_cache/fps", PROPERTY_HINT_RANGE, "1,240,1"));
+	GLOBAL_DEF("spine/events/buffer_size", 256);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/events/buffer_size", PropertyInfo(Variant::INT, "spine/events/buffer_size", PROPERTY_HINT_RANGE, "16,65536,1"));
+	GLOBAL_DEF("spine/pool/max_size", 32);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/pool/max_size", PropertyInfo(Variant::INT, "spine/pool/max_size", PROPERTY_HINT_RANGE, "0,4096,1"));
+	GLOBAL_DEF("spine/pool/prewarm", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/pool/prewarm", PropertyInfo(Variant::INT, "spine/pool/prewarm", PROPERTY_HINT_RANGE, "0,4096,1"));
+	GLOBAL_DEF("spine/timelines/compression_tolerance", 0.0);
+	GLOBAL_DEF("spine/timelines/compression_rotation_tolerance", 0.1);
+	GLOBAL_DEF("spine/timelines/compression_scale_tolerance", 0.001);
+	GLOBAL_DEF("spine/timelines/dense_sampling_fps", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/timelines/dense_sampling_fps", PropertyInfo(Variant::REAL, "spine/timelines/dense_sampling_fps", PROPERTY_HINT_RANGE, "0,240,1"));
+	GLOBAL_DEF("spine/timelines/dense_sampling_max_memory", 262144);
+	GLOBAL_DEF("spine/timelines/dense_sampling_tolerance", 0.01);
+	GLOBAL_DEF_RST("spine/memory/allocator", SpineAllocator::MODE_HEAP);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/memory/allocator", PropertyInfo(Variant::INT, "spine/memory/allocator", PROPERTY_HINT_ENUM, "Heap,Pools,Pools and Arenas"));
+
+	GLOBAL_DEF_RST("spine/memory/track_allocations", false);
+	GLOBAL_DEF_RST("spine/import/cook_skeletons", false);
+	GLOBAL_DEF("spine/textures/lazy_pages", false);
+	GLOBAL_DEF("spine/textures/lazy_load_mode", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/textures/lazy_load_mode", PropertyInfo(Variant::INT, "spine/textures/lazy_load_mode", PROPERTY_HINT_ENUM, "Synchronous,Deferred"));
+	GLOBAL_DEF("spine/textures/deferred_loads_per_frame", 1);
+	GLOBAL_DEF("spine/textures/memory_budget", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("spine/textures/memory_budget", PropertyInfo(Variant::INT, "spine/textures/memory_budget", PROPERTY_HINT_RANGE, "0,2147483647,1024"));
+	GLOBAL_DEF("spine/textures/evict_after", 30.0);
+	GLOBAL_DEF("spine/textures/atlas_variants", "2,4");
+	GLOBAL_DEF("spine/textures/max_variant_scale", 4.0);
+	GLOBAL_DEF("spine/textures/variant_scale_bias", 1.0);
+	GLOBAL_DEF("spine/textures/variant_downscale_delay", 2.0);
+	GLOBAL_DEF("spine/skins/max_baked_texture_size", 4096);
+
+	SpineAllocator::init((SpineAllocator::Mode)(int)GLOBAL_GET("spine/memory/allocator"), GLOBAL_GET("spine/memory/track_allocations"));
+	SpineRuntime::init();
+	SpineStringNames::create();
+
 	ClassDB::register_class<Spine>();
 	ClassDB::register_class<SpineResource>();
+	ClassDB::register_class<SpineMemory>();
+	spine_memory = memnew(SpineMemory);
+	Engine::get_singleton()->add_singleton(Engine::Singleton("SpineMemory", SpineMemory::get_singleton()));
 	// ClassDB::register_class<SpineRuntime_3_6>();
 	// ClassDB::register_class<SpineRuntime_4_1>();
 #ifdef MODULE_SPINE_WITH_ANIMATION_NODES
@@ -169,11 +319,22 @@ void register_spine_types() {
 #endif
 	resource_loader_spine.instance();
 	ResourceLoader::add_resource_format_loader(resource_loader_spine);
+#ifdef TOOLS_ENABLED
+	// opt-in, the importer claims every .skel and .spjson file of the project
+	if (Engine::get_singleton()->is_editor_hint() && GLOBAL_GET("spine/import/cook_skeletons")) {
+		Ref<ResourceImporterSpine> spine_importer;
+		spine_importer.instance();
+		ResourceFormatImporter::get_singleton()->add_importer(spine_importer);
+	}
+#endif
 }
 
 void unregister_spine_types() {
 
 	ResourceLoader::remove_resource_format_loader(resource_loader_spine);
 	resource_loader_spine.unref();
+	memdelete(spine_memory);
+	SpineStringNames::free();
+	SpineRuntime::finish();
 
 }
\ No newline at end of file
@@ -11,6 +11,8 @@
 #define SPINE_RUNTIME_CLASS SPINE_CONC(SpineRuntime_, SPINE_RUNTIME_IMPL)
 #define SPINE_TEXTURE_LOADER_CLASS SPINE_CONC(SpineTextureLoader_, SPINE_RUNTIME_IMPL)
 #define SPINE_EXTENSION_CLASS SPINE_CONC(SpineExtension_, SPINE_RUNTIME_IMPL)
+#define SPINE_COMPOSED_SKIN_CLASS SPINE_CONC(SpineComposedSkin_, SPINE_RUNTIME_IMPL)
+#define SPINE_DENSE_TIMELINE_CLASS SPINE_CONC(SpineDenseTimeline_, SPINE_RUNTIME_IMPL)
 #define SPINE_RUNTIME_VERSION_STRING SPINE_STR(SPINE_RUNTIME_IMPL)
 
 
@@ -18,35 +20,25 @@
 #include "scene/resources/texture.h"
 #include "scene/resources/convex_polygon_shape_2d.h"
 #include "scene/2d/collision_object_2d.h"
+#include "core/project_settings.h"
+#include "core/os/mutex.h"
+#include "core/set.h"
+
+#include "modules/spine/runtime/spine_allocator.h"
+#include "modules/spine/runtime/common_timelines.impl.cpp"
 
 class SPINE_EXTENSION_CLASS: public sp::SpineExtension {
     virtual void *_alloc(size_t p_size, const char *file, int line) {
-        if (p_size == 0)
-            return NULL;
-        return memalloc(p_size);
+        return SpineAllocator::alloc(p_size, file, line, SPINE_RUNTIME_VERSION_STRING);
     }
     virtual void *_calloc(size_t p_size, const char *file, int line) {
-        if (p_size == 0)
-		    return NULL;
-        void* ptr = memalloc(p_size);
-        if (ptr) {
-            memset(ptr, 0, p_size);
-        }
-        return ptr;
+        return SpineAllocator::calloc(p_size, file, line, SPINE_RUNTIME_VERSION_STRING);
     }
     virtual void *_realloc(void *ptr, size_t p_size, const char *file, int line) {
-        if (p_size == 0)
-            return NULL;
-        if (ptr == NULL) {
-            return memalloc(p_size);
-        } else {
-            return memrealloc(ptr, p_size);
-        }
+        return SpineAllocator::realloc(ptr, p_size, file, line, SPINE_RUNTIME_VERSION_STRING);
     }
     virtual void _free(void *ptr, const char *file, int line) {
-        if (ptr == NULL)
-            return;
-        memfree(ptr);
+        SpineAllocator::free(ptr);
     }
     virtual char *_readFile(const sp::String &p_path, int *p_length) {
         String path = p_path.buffer();
@@ -75,192 +67,739 @@ class SPINE_TEXTURE_LOADER_CLASS : public sp::TextureLoader {
 		if (path.begins_with("res:/") && !path.begins_with("res://")) {
 			path = path.replace("res:/", "res://");
 		}
-		Ref<Texture> *ref = memnew(Ref<Texture>);
-		*ref = ResourceLoader::load(path);
-		if (!ref->is_null()) {
-			page.setRendererObject(ref);
-			page.width = (*ref)->get_width();
-			page.height = (*ref)->get_height();
-		} else {
-			memdelete(ref);
-			Ref<Image> img = memnew(Image);
-			if (img->load(path) == OK) {
-				Ref<ImageTexture> *imgtex = memnew(Ref<ImageTexture>);
-				(*imgtex) = Ref<ImageTexture>(memnew(ImageTexture));
-				(*imgtex)->create_from_image(img);
-				page.setRendererObject(imgtex);
-				page.width = (*imgtex)->get_width();
-				page.height = (*imgtex)->get_height();
-			} else {
-				ERR_FAIL();
-			}
-		}
+		int width = page.width, height = page.height;
+		SpinePage *texture = SpineRuntime::load_page(path, &width, &height);
+		ERR_FAIL_COND(!texture);
+		page.setRendererObject(texture);
+		page.width = width;
+		page.height = height;
 	}
 
 	virtual void unload(void *texture) {
-
+		// pages of atlases parsed for cooking have no texture
+		if (texture) SpineRuntime::unload_page((SpinePage *)texture);
 	}
 };
 
+static SPINE_TEXTURE_LOADER_CLASS spine_texture_loader;
+
+#ifdef SPINE_RUNTIME_4
+// Builds the atlas from a table cooked by cook_atlas(), loading its pages
+// the way sp::Atlas does.
+static sp::Atlas *spine_build_atlas(const SpineAtlasTable &p_table, const String &p_dir) {
+	sp::TextureLoader *loader = &spine_texture_loader;
+	sp::Atlas *atlas = new sp::Atlas("", 0, p_dir.utf8().get_data(), loader);
+	sp::Vector<sp::AtlasPage *> &pages = atlas->getPages();
+	for (int i = 0; i < p_table.pages.size(); i++) {
+		const SpineAtlasTable::Page &source = p_table.pages[i];
+		sp::AtlasPage *page = new sp::AtlasPage(sp::String(source.name.utf8().get_data()));
+		page->format = (sp::Format)source.format;
+		page->minFilter = (sp::TextureFilter)source.min_filter;
+		page->magFilter = (sp::TextureFilter)source.mag_filter;
+		page->uWrap = (sp::TextureWrap)source.u_wrap;
+		page->vWrap = (sp::TextureWrap)source.v_wrap;
+		page->width = source.width;
+		page->height = source.height;
+		page->pma = source.pma;
+#ifdef SPINE_RUNTIME_4_1
+		page->texturePath = page->name;
+		page->index = i;
+#endif
+		pages.add(page);
+		loader->load(*page, sp::String(p_dir.plus_file(source.name).utf8().get_data()));
+	}
+	sp::Vector<sp::AtlasRegion *> &regions = atlas->getRegions();
+	for (int i = 0; i < p_table.regions.size(); i++) {
+		const SpineAtlasTable::Region &source = p_table.regions[i];
+		sp::AtlasRegion *region = new sp::AtlasRegion();
+		region->page = pages[source.page];
+#ifdef SPINE_RUNTIME_4_1
+		region->rendererObject = region->page;
+#else
+		region->rotate = source.degrees == 90;
+#endif
+		region->name = sp::String(source.name.utf8().get_data());
+		region->x = source.x;
+		region->y = source.y;
+		region->width = source.width;
+		region->height = source.height;
+		region->u = source.u;
+		region->v = source.v;
+		region->u2 = source.u2;
+		region->v2 = source.v2;
+		region->offsetX = source.offset_x;
+		region->offsetY = source.offset_y;
+		region->originalWidth = source.original_width;
+		region->originalHeight = source.original_height;
+		region->index = source.index;
+		region->degrees = source.degrees;
+		for (int j = 0; j < source.splits.size(); j++) {
+			region->splits.add(source.splits[j]);
+		}
+		for (int j = 0; j < source.pads.size(); j++) {
+			region->pads.add(source.pads[j]);
+		}
+		regions.add(region);
+	}
+	return atlas;
+}
+#endif
+
 static void spine_animation_callback(sp::AnimationState *state, sp::EventType type, sp::TrackEntry *entry, sp::Event *event) {
     SPINE_RUNTIME_CLASS* self = (SPINE_RUNTIME_CLASS*)state->getRendererObject();
     switch (type) {
 		case sp::EventType_Start:
-			self->emit_signal("event", "animation_start", entry->getTrackIndex());
+			self->_push_event(SpineEventBuffer::EVENT_START, entry->getTrackIndex());
 			break;
 		case sp::EventType_Complete:
-			self->emit_signal("event", "animation_complete", entry->getTrackIndex(), 1);
+			self->_push_event(SpineEventBuffer::EVENT_COMPLETE, entry->getTrackIndex(), NULL, 1);
+			break;
+		case sp::EventType_Event:
+			self->_push_event(SpineEventBuffer::EVENT_EVENT, entry->getTrackIndex(), &event->getData(), event->getIntValue(), event->getFloatValue(), event->getStringValue().buffer());
 			break;
-		case sp::EventType_Event: {
-			Dictionary data;
-			data["name"] = event->getData().getName().buffer();;
-			data["int"] = event->getIntValue();
-			data["float"] = event->getFloatValue();
-			data["string"] = event->getStringValue().buffer();
-			self->emit_signal("event", "animation_event", entry->getTrackIndex(), data);
-		} break;
 		case sp::EventType_End:
-			self->emit_signal("event", "animation_end", entry->getTrackIndex());
+			self->_push_event(SpineEventBuffer::EVENT_END, entry->getTrackIndex());
+			break;
+		default:
 			break;
 	}
 }
 
 static Ref<Texture> spine_get_texture(sp::RegionAttachment *attachment) {
-    Ref<Texture> *ref = (Ref<Texture>*)((sp::AtlasRegion*)attachment->getRendererObject())->page->getRendererObject();
-    return ref? *ref : NULL;
+    return SpineRuntime::get_page_texture((SpinePage*)((sp::AtlasRegion*)attachment->getRendererObject())->page->getRendererObject());
 }
 static Ref<Texture> spine_get_texture(sp::MeshAttachment *attachment) {
-    Ref<Texture> *ref =  (Ref<Texture>*)((sp::AtlasRegion*)attachment->getRendererObject())->page->getRendererObject();
-    return ref? *ref : NULL;
+    return SpineRuntime::get_page_texture((SpinePage*)((sp::AtlasRegion*)attachment->getRendererObject())->page->getRendererObject());
 }
 
+#if defined(SPINE_RUNTIME_3_8) || defined(SPINE_RUNTIME_4)
+// Skin combined from several skins by set_skins(). A baked one draws
+// copies of the attachments from a single texture holding just the
+// regions they use; its page, regions and texture belong to it. Freed when
+// the last runtime wearing it lets go.
+struct SPINE_COMPOSED_SKIN_CLASS {
+	sp::Skin *skin;
+	sp::AtlasPage *page;
+	Vector<sp::AtlasRegion *> regions;
+	SpinePage *texture;
+	String key;
+	int users;
+	// max_baked_texture_size a failed bake was tried with
+	int bake_size;
+};
+
+static void spine_free_composed_skin(SPINE_COMPOSED_SKIN_CLASS *p_composed) {
+	delete p_composed->skin;
+	for (int i = 0; i < p_composed->regions.size(); i++) {
+		delete p_composed->regions[i];
+	}
+	if (p_composed->page) delete p_composed->page;
+	if (p_composed->texture) SpineRuntime::unload_page(p_composed->texture);
+	memdelete(p_composed);
+}
+
+static void spine_release_composed_skin(SpineResource *p_res, SPINE_COMPOSED_SKIN_CLASS *p_composed) {
+	if (--p_composed->users > 0) return;
+	void **cached = p_res->composed_skins.getptr(p_composed->key);
+	if (cached && *cached == p_composed) {
+		p_res->composed_skins.erase(p_composed->key);
+	}
+	spine_free_composed_skin(p_composed);
+}
+
+// Region and uvs of an attachment drawn from the atlas. Sequences switch
+// regions while playing, so they keep drawing from their pages.
+static sp::AtlasRegion *spine_attachment_region(sp::Attachment *p_attachment, sp::Vector<float> *&r_uvs) {
+	if (p_attachment->getRTTI().isExactly(sp::RegionAttachment::rtti)) {
+		sp::RegionAttachment *attachment = (sp::RegionAttachment *)p_attachment;
+#ifdef SPINE_RUNTIME_4_1
+		if (attachment->getSequence()) return NULL;
+#endif
+		r_uvs = &attachment->getUVs();
+		return (sp::AtlasRegion *)attachment->getRendererObject();
+	} else if (p_attachment->getRTTI().isExactly(sp::MeshAttachment::rtti)) {
+		sp::MeshAttachment *attachment = (sp::MeshAttachment *)p_attachment;
+#ifdef SPINE_RUNTIME_4_1
+		if (attachment->getSequence()) return NULL;
+#endif
+		r_uvs = &attachment->getUVs();
+		return (sp::AtlasRegion *)attachment->getRendererObject();
+	}
+	return NULL;
+}
+
+static void spine_set_attachment_region(sp::Attachment *p_attachment, sp::AtlasRegion *p_region) {
+	if (p_attachment->getRTTI().isExactly(sp::RegionAttachment::rtti)) {
+		((sp::RegionAttachment *)p_attachment)->setRendererObject(p_region);
+	} else {
+		((sp::MeshAttachment *)p_attachment)->setRendererObject(p_region);
+	}
+}
+
+// Copies the regions used by the skin's attachments into one texture of at
+// most p_max_size pixels and moves the attachments' uvs onto it. Pages are
+// read from their files, so lazy, evicted and pending pages bake too. Leaves
+// the skin untouched when a page can't be read or the regions don't fit.
+static bool spine_bake_skin(SPINE_COMPOSED_SKIN_CLASS *p_composed, int p_max_size) {
+	Vector<sp::Attachment *> attachments;
+	Vector<int> attachment_regions;
+	HashMap<uint64_t, int> attachment_ids;
+	// regions in the order they are packed, with their rect in the page image
+	Vector<sp::AtlasRegion *> sources;
+	Vector<Size2> source_sizes;
+	Vector<Rect2> rects;
+	Vector<Ref<Image> > images;
+	HashMap<uint64_t, int> region_ids;
+	HashMap<uint64_t, Ref<Image> > page_images;
+	uint32_t flags = Texture::FLAGS_DEFAULT;
+
+	sp::Skin::AttachmentMap::Entries entries = p_composed->skin->getAttachments();
+	while (entries.hasNext()) {
+		sp::Attachment *attachment = entries.next()._attachment;
+		sp::Vector<float> *uvs = NULL;
+		sp::AtlasRegion *region = spine_attachment_region(attachment, uvs);
+		if (region == NULL || attachment_ids.has((uint64_t)attachment)) continue;
+		const int *id = region_ids.getptr((uint64_t)region);
+		if (id == NULL) {
+			SpinePage *page = (SpinePage *)region->page->getRendererObject();
+			Ref<Image> *page_image = page_images.getptr((uint64_t)page);
+			if (page_image == NULL) {
+				Ref<Image> data = SpineRuntime::get_page_image(page);
+				ERR_FAIL_COND_V_MSG(data.is_null(), false, "Can't read spine atlas page: " + page->path);
+				if (data->is_compressed()) {
+					data->decompress();
+				}
+				if (page->texture.is_valid()) {
+					flags = page->texture->get_flags();
+				}
+				page_images[(uint64_t)page] = data;
+				page_image = page_images.getptr((uint64_t)page);
+			}
+			Size2 size = (*page_image)->get_size();
+			Rect2 rect(Math::round(region->u * size.x), Math::round(region->v * size.y), Math::round((region->u2 - region->u) * size.x), Math::round((region->v2 - region->v) * size.y));
+			region_ids[(uint64_t)region] = sources.size();
+			sources.push_back(region);
+			source_sizes.push_back(size);
+			rects.push_back(rect);
+			images.push_back((*page_image)->get_rect(rect));
+			id = region_ids.getptr((uint64_t)region);
+		}
+		attachment_ids[(uint64_t)attachment] = attachments.size();
+		attachments.push_back(attachment);
+		attachment_regions.push_back(*id);
+	}
+	if (sources.empty()) return false;
+
+	Vector<Point2> positions;
+	Ref<Image> image = SpineRuntime::pack_images(images, p_max_size, positions);
+	ERR_FAIL_COND_V_MSG(image.is_null(), false, "Skin regions don't fit into a baked texture of " + itos(p_max_size) + " pixels: " + String::utf8(p_composed->skin->getName().buffer()));
+	Ref<ImageTexture> texture = memnew(ImageTexture);
+	texture->create_from_image(image, flags);
+	Size2 size = image->get_size();
+
+	p_composed->texture = SpineRuntime::create_page(texture);
+	p_composed->page = new sp::AtlasPage(p_composed->skin->getName());
+	p_composed->page->setRendererObject(p_composed->texture);
+	p_composed->page->width = size.x;
+	p_composed->page->height = size.y;
+	for (int i = 0; i < sources.size(); i++) {
+		sp::AtlasRegion *region = new sp::AtlasRegion();
+		region->page = p_composed->page;
+		region->name = sources[i]->name;
+		region->u = positions[i].x / size.x;
+		region->v = positions[i].y / size.y;
+		region->u2 = (positions[i].x + rects[i].size.x) / size.x;
+		region->v2 = (positions[i].y + rects[i].size.y) / size.y;
+		p_composed->regions.push_back(region);
+	}
+	for (int i = 0; i < attachments.size(); i++) {
+		int id = attachment_regions[i];
+		sp::Vector<float> *uvs = NULL;
+		spine_attachment_region(attachments[i], uvs);
+		for (size_t j = 0; j + 1 < uvs->size(); j += 2) {
+			(*uvs)[j] = ((*uvs)[j] * source_sizes[id].x - rects[id].position.x + positions[id].x) / size.x;
+			(*uvs)[j + 1] = ((*uvs)[j + 1] * source_sizes[id].y - rects[id].position.y + positions[id].y) / size.y;
+		}
+		spine_set_attachment_region(attachments[i], p_composed->regions[id]);
+	}
+	return true;
+}
+
+static SPINE_COMPOSED_SKIN_CLASS *spine_compose_skin(sp::SkeletonData *p_data, const Vector<int> &p_skin_ids, const String &p_name, bool p_bake) {
+	SPINE_COMPOSED_SKIN_CLASS *composed = memnew(SPINE_COMPOSED_SKIN_CLASS);
+	composed->page = NULL;
+	composed->texture = NULL;
+	composed->key = p_name;
+	composed->users = 0;
+	composed->bake_size = 0;
+	composed->skin = new sp::Skin(p_name.utf8().get_data());
+	for (int i = 0; i < p_skin_ids.size(); i++) {
+		composed->skin->addSkin(p_data->getSkins()[p_skin_ids[i]]);
+	}
+	if (p_bake) {
+		// baking rewrites uvs, so it works on copies of the attachments
+		sp::Skin *source = composed->skin;
+		composed->skin = new sp::Skin(source->getName());
+		composed->skin->copySkin(source);
+		int max_size = GLOBAL_GET("spine/skins/max_baked_texture_size");
+		if (spine_bake_skin(composed, max_size)) {
+			delete source;
+		} else {
+			delete composed->skin;
+			composed->skin = source;
+			composed->bake_size = max_size;
+		}
+	}
+	return composed;
+}
+#endif
+
 void SPINE_RUNTIME_CLASS::_rt_get_property_list(List<PropertyInfo> *p_list) const {
 	
 }
 
 bool SPINE_RUNTIME_CLASS::_rt_get(const StringName &p_name, Variant &r_ret) const {
-	String name = p_name;
-	if (name.begins_with("bone/")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size() != 3) return true;
-		sp::Bone *bone = skeleton->findBone(params[1].utf8().get_data());
-		ERR_FAIL_COND_V(bone==NULL, false);
-		if (params[2] == "rotation")
-			r_ret = bone->getRotation();
-		else if (params[2] == "position")
-			r_ret = Vector2(bone->getX(), bone->getY());
-		return true;
-	} else {
-		return false;
+	const SpineResource::Property *property = resource.is_valid() ? resource->find_property(p_name) : NULL;
+	if (property == NULL) return false;
+	if (skeleton == NULL) return true;
+	switch (property->target) {
+		case SpineResource::PROPERTY_BONE: {
+			sp::Bone *bone = skeleton->getBones()[property->index];
+			if (property->field == SpineResource::FIELD_ROTATION)
+				r_ret = bone->getRotation();
+			else
+				r_ret = Vector2(bone->getX(), bone->getY());
+		} break;
+		case SpineResource::PROPERTY_SLOT: {
+			sp::Color &c = skeleton->getSlots()[property->index]->getColor();
+			r_ret = Color(c.r, c.g, c.b, c.a);
+		} break;
+		case SpineResource::PROPERTY_PATH: {
+			sp::PathConstraint *pc = skeleton->getPathConstraints()[property->index];
+			if (property->field == SpineResource::FIELD_POSITION)
+				r_ret = pc->getPosition();
+			else if (property->field == SpineResource::FIELD_SPACING)
+				r_ret = pc->getSpacing();
+#ifdef SPINE_RUNTIME_3
+			else if (property->field == SpineResource::FIELD_TRANSLATE_MIX)
+				r_ret = pc->getTranslateMix();
+			else
+				r_ret = pc->getRotateMix();
+#else
+			else if (property->field == SpineResource::FIELD_TRANSLATE_MIX)
+				r_ret = pc->getMixX();
+			else
+				r_ret = pc->getMixRotate();
+#endif
+		} break;
 	}
+	return true;
 }
 
 bool SPINE_RUNTIME_CLASS::_rt_set(const StringName &p_name, const Variant &p_value) {
-    String name = p_name;
-	if (name.begins_with("path")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size()!=3) return true;
-		sp::PathConstraint *pc = skeleton->findPathConstraint(params[1].utf8().get_data());
-		ERR_FAIL_COND_V(pc==NULL, true);
-		if (params[2] == "position") {
-			pc->setPosition(p_value);
-		} else if (params[2] == "tmix"){
+	const SpineResource::Property *property = resource.is_valid() ? resource->find_property(p_name) : NULL;
+	if (property == NULL) return false;
+	if (skeleton == NULL) return true;
+	switch (property->target) {
+		case SpineResource::PROPERTY_BONE: {
+			sp::Bone *bone = skeleton->getBones()[property->index];
+			if (property->field == SpineResource::FIELD_ROTATION) {
+				bone->setRotation(p_value);
+			} else {
+				Vector2 v(p_value);
+				bone->setX(v.x);
+				bone->setY(v.y);
+			}
+			_mark_bone_dirty(bone);
+			manual_pose = true;
+		} break;
+		case SpineResource::PROPERTY_SLOT: {
+			Color c = p_value;
+			skeleton->getSlots()[property->index]->getColor().set(
+				skeleton->getColor().r * c.r,
+				skeleton->getColor().g * c.g,
+				skeleton->getColor().b * c.b,
+				skeleton->getColor().a * c.a
+			);
+		} break;
+		case SpineResource::PROPERTY_PATH: {
+			sp::PathConstraint *pc = skeleton->getPathConstraints()[property->index];
+			if (property->field == SpineResource::FIELD_POSITION) {
+				pc->setPosition(p_value);
+			} else if (property->field == SpineResource::FIELD_TRANSLATE_MIX) {
 #ifdef SPINE_RUNTIME_3
-			pc->setTranslateMix(p_value);
+				pc->setTranslateMix(p_value);
 #else
-			pc->setMixX(p_value);
-			pc->setMixY(p_value);
+				pc->setMixX(p_value);
+				pc->setMixY(p_value);
 #endif
-		} else if (params[2] == "rmix"){
+			} else if (property->field == SpineResource::FIELD_ROTATE_MIX) {
 #ifdef SPINE_RUNTIME_3
-			pc->setRotateMix(p_value);
+				pc->setRotateMix(p_value);
 #else
-			pc->setMixRotate(p_value);
+				pc->setMixRotate(p_value);
 #endif
-		} else if (params[2] == "spacing"){
-			pc->setSpacing(p_value);
-		}
-		skeleton->updateWorldTransform();
-        return true;
-	} else if (name.begins_with("bone")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size() != 3) return true;
-		sp::Bone *bone = skeleton->findBone(params[1].utf8().get_data());
-		ERR_FAIL_COND_V(bone==NULL, true);
-		if (params[2] == "rotation"){
-			bone->setRotation(p_value);
+			} else {
+				pc->setSpacing(p_value);
+			}
+			sp::Vector<sp::Bone*> &bones = pc->getBones();
+			for (int i = 0, n = bones.size(); i < n; i++) {
+				_mark_bone_dirty(bones[i]);
+			}
+			manual_pose = true;
+		} break;
+	}
+	return true;
+}
+
+// Reports the bones a constraint reads (r_target) and writes (r_bones).
+// Weighted path attachments read arbitrary bones, flagged with r_any.
+static bool spine_constraint_bones(sp::Updatable *p_updatable, sp::Bone *&r_target, sp::Vector<sp::Bone*> *&r_bones, bool &r_any) {
+	r_any = false;
+	if (p_updatable->getRTTI().isExactly(sp::IkConstraint::rtti)) {
+		sp::IkConstraint *constraint = (sp::IkConstraint*)p_updatable;
+		r_target = constraint->getTarget();
+		r_bones = &constraint->getBones();
+	} else if (p_updatable->getRTTI().isExactly(sp::TransformConstraint::rtti)) {
+		sp::TransformConstraint *constraint = (sp::TransformConstraint*)p_updatable;
+		r_target = constraint->getTarget();
+		r_bones = &constraint->getBones();
+	} else if (p_updatable->getRTTI().isExactly(sp::PathConstraint::rtti)) {
+		sp::PathConstraint *constraint = (sp::PathConstraint*)p_updatable;
+		sp::Attachment *attachment = constraint->getTarget()->getAttachment();
+		r_target = &constraint->getTarget()->getBone();
+		r_bones = &constraint->getBones();
+		r_any = attachment != NULL && attachment->getRTTI().isExactly(sp::PathAttachment::rtti) && ((sp::PathAttachment*)attachment)->getBones().size() > 0;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void SPINE_RUNTIME_CLASS::_mark_bone_dirty(sp::Bone *p_bone) {
+	dirty_bones.write[p_bone->getData().getIndex()] = 1;
+	bones_dirty = true;
+}
+
+void SPINE_RUNTIME_CLASS::_clear_dirty_bones() {
+	if (!bones_dirty) return;
+	memset(dirty_bones.ptrw(), 0, dirty_bones.size());
+	bones_dirty = false;
+}
+
+// Recomputes world transforms after property writes: only the dirty bones,
+// their descendants and the constraints reading any of them are updated,
+// in skeleton update cache order.
+void SPINE_RUNTIME_CLASS::_update_dirty_bones() const {
+	if (!bones_dirty || skeleton == NULL) return;
+	bones_dirty = false;
+
+	sp::Vector<sp::Bone*> &bones = skeleton->getBones();
+	sp::Vector<sp::Updatable*> &cache = skeleton->getUpdateCacheList();
+	int count = bones.size();
+	affected_bones.resize(count);
+	uint8_t *affected = affected_bones.ptrw();
+	memcpy(affected, dirty_bones.ptr(), count);
+	memset(dirty_bones.ptrw(), 0, count);
+
+	sp::Bone *target;
+	sp::Vector<sp::Bone*> *constrained;
+	bool any;
+
+	// Children follow their parents, and a constraint that reads an affected
+	// bone rewrites all of its bones, so grow the set until it is stable.
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int i = 0; i < count; i++) {
+			sp::Bone *parent = bones[i]->getParent();
+			if (!affected[i] && parent != NULL && affected[parent->getData().getIndex()]) {
+				affected[i] = 1;
+				changed = true;
+			}
 		}
-		else if (params[2] == "position"){
-			Vector2 v(p_value);
-			bone->setX(v.x);
-			bone->setY(v.y);
+		for (int i = 0, n = cache.size(); i < n; i++) {
+			if (!spine_constraint_bones(cache[i], target, constrained, any)) continue;
+			bool reads = any || (target != NULL && affected[target->getData().getIndex()]);
+			for (int j = 0, m = constrained->size(); !reads && j < m; j++) {
+				reads = affected[(*constrained)[j]->getData().getIndex()];
+			}
+			if (!reads) continue;
+			for (int j = 0, m = constrained->size(); j < m; j++) {
+				uint8_t &flag = affected[(*constrained)[j]->getData().getIndex()];
+				if (!flag) {
+					flag = 1;
+					changed = true;
+				}
+			}
 		}
-		skeleton->updateWorldTransform();
-        return true;
-	} else if (name.begins_with("slot")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size() != 3) return true;
-		sp::Slot *slot = skeleton->findSlot(params[1].utf8().get_data());
-		ERR_FAIL_COND_V(slot==NULL, true);
-		if (params[2] == "color"){
-			Color c = p_value;
-			slot->getColor().set(
-				skeleton->getColor().r * c.r,
-				skeleton->getColor().g * c.g,
-				skeleton->getColor().b * c.b,
-				skeleton->getColor().a * c.a
-			);
+	}
+
+	for (int i = 0, n = cache.size(); i < n; i++) {
+		sp::Updatable *updatable = cache[i];
+		if (updatable->getRTTI().isExactly(sp::Bone::rtti)) {
+			sp::Bone *bone = (sp::Bone*)updatable;
+			if (affected[bone->getData().getIndex()]) {
+				bone->updateWorldTransform(bone->getX(), bone->getY(), bone->getRotation(), bone->getScaleX(), bone->getScaleY(), bone->getShearX(), bone->getShearY());
+			}
+		} else if (spine_constraint_bones(updatable, target, constrained, any)) {
+			bool reads = any || (target != NULL && affected[target->getData().getIndex()]);
+			for (int j = 0, m = constrained->size(); !reads && j < m; j++) {
+				reads = affected[(*constrained)[j]->getData().getIndex()];
+			}
+			if (reads) updatable->update();
 		}
-        return true;
-	} else {
-        return false;
-    }
+	}
 }
 
-void SPINE_RUNTIME_CLASS::init() {
+static void spine_index_names(SpineResource *p_res, sp::SkeletonData *p_data) {
+	sp::Vector<sp::BoneData*> &bones = p_data->getBones();
+	for (int i = 0, n = bones.size(); i < n; i++) {
+		String name = String::utf8(bones[i]->getName().buffer());
+		p_res->bone_ids.set(name, i);
+		p_res->index_properties(SpineResource::PROPERTY_BONE, name, i);
+	}
+	sp::Vector<sp::SlotData*> &slots = p_data->getSlots();
+	for (int i = 0, n = slots.size(); i < n; i++) {
+		String name = String::utf8(slots[i]->getName().buffer());
+		p_res->slot_ids.set(name, i);
+		p_res->index_properties(SpineResource::PROPERTY_SLOT, name, i);
+	}
+	sp::Vector<sp::PathConstraintData*> &paths = p_data->getPathConstraints();
+	for (int i = 0, n = paths.size(); i < n; i++) {
+		p_res->index_properties(SpineResource::PROPERTY_PATH, String::utf8(paths[i]->getName().buffer()), i);
+	}
+	sp::Vector<sp::Animation*> &animations = p_data->getAnimations();
+	p_res->animation_names.resize(animations.size());
+	p_res->animation_durations.resize(animations.size());
+	for (int i = 0, n = animations.size(); i < n; i++) {
+		StringName name = String::utf8(animations[i]->getName().buffer());
+		p_res->animation_ids.set(name, i);
+		p_res->animation_names.write[i] = name;
+		p_res->animation_durations.write[i] = animations[i]->getDuration();
+	}
+	sp::Vector<sp::EventData*> &events = p_data->getEvents();
+	p_res->event_names.resize(events.size());
+	for (int i = 0, n = events.size(); i < n; i++) {
+		p_res->event_names.write[i] = String::utf8(events[i]->getName().buffer());
+		p_res->event_ids.set((uint64_t)events[i], i);
+	}
+	sp::Vector<sp::Skin*> &skins = p_data->getSkins();
+	p_res->skin_names.resize(skins.size());
+	for (int i = 0, n = skins.size(); i < n; i++) {
+		StringName name = String::utf8(skins[i]->getName().buffer());
+		p_res->skin_ids.set(name, i);
+		p_res->skin_names.write[i] = name;
+	}
+	float width = p_data->getWidth(), height = p_data->getHeight();
+#if defined(SPINE_RUNTIME_3_8) || defined(SPINE_RUNTIME_4)
+	p_res->bounds = Rect2(p_data->getX(), -p_data->getY() - height, width, height);
+#else
+	// no origin before 3.8, assume the skeleton stands on it
+	p_res->bounds = Rect2(-width / 2, -height, width, height);
+#endif
+}
+
+sp::Bone *SPINE_RUNTIME_CLASS::_find_bone(const StringName &p_name) const {
+	int id = resource->find_bone_id(p_name);
+	return id < 0 ? NULL : skeleton->getBones()[id];
+}
 
+sp::Slot *SPINE_RUNTIME_CLASS::_find_slot(const StringName &p_name) const {
+	int id = resource->find_slot_id(p_name);
+	return id < 0 ? NULL : skeleton->getSlots()[id];
 }
 
-Ref<SpineResource> SPINE_RUNTIME_CLASS::load_resource(const String &p_path) {
-	sp::TextureLoader *loader = new SPINE_TEXTURE_LOADER_CLASS();
+sp::Animation *SPINE_RUNTIME_CLASS::_find_animation(const StringName &p_name) const {
+	int id = resource->find_animation_id(p_name);
+	return id < 0 ? NULL : skeleton->getData()->getAnimations()[id];
+}
+
+void SPINE_RUNTIME_CLASS::init() {
 
+}
+
+// Skeletons using the same atlas file share one sp::Atlas, see
+// SpineRuntime::share_atlas().
+Ref<SpineResource> SPINE_RUNTIME_CLASS::load_resource(const SkeletonSource &p_source) {
 	Ref<SpineResource> resource;
     sp::SkeletonData *skeletonData = NULL;
 
-	String p_atlas = p_path.get_basename() + ".atlas";
-	sp::Atlas *atlas = new sp::Atlas(p_atlas.utf8().get_data(), loader);
-	if (!atlas->getPages().size()) {
-		return resource;
+	sp::Atlas *atlas = (sp::Atlas *)SpineRuntime::find_atlas(SPINE_RUNTIME_VERSION_STRING, p_source.get_atlas_key());
+	if (!atlas) {
+#ifdef SPINE_RUNTIME_4
+		SpineAtlasTable table;
+		if (!p_source.atlas_table.empty() && table.decode(p_source.atlas_table) == OK && !table.pages.empty()) {
+			atlas = spine_build_atlas(table, p_source.atlas_path.get_base_dir());
+		} else
+#endif
+		{
+			Vector<uint8_t> atlas_data = SpineRuntime::get_atlas_data(p_source);
+			ERR_FAIL_COND_V_MSG(atlas_data.empty(), resource, "Can't open spine atlas: " + p_source.atlas_path);
+			atlas = new sp::Atlas((const char *)atlas_data.ptr(), atlas_data.size() - 1, p_source.atlas_path.get_base_dir().utf8().get_data(), &spine_texture_loader);
+		}
+		if (!atlas->getPages().size()) {
+			delete atlas;
+			return resource;
+		}
+		sp::Atlas *shared = (sp::Atlas *)SpineRuntime::share_atlas(SPINE_RUNTIME_VERSION_STRING, p_source.get_atlas_key(), atlas);
+		if (shared != atlas) {
+			delete atlas;
+			atlas = shared;
+		}
 	}
 
 	String err_msg;
-	if (p_path.get_extension() == "json") {
+	if (SpineRuntime::is_json(p_source.path)) {
 		sp::SkeletonJson json(atlas);
 		json.setScale(1);
-		skeletonData = json.readSkeletonDataFile(p_path.utf8().get_data());
+		skeletonData = json.readSkeletonData((const char *)p_source.data.ptr());
 		err_msg = json.getError().buffer();
-	} else if (p_path.get_extension() == "skel") {
+	} else if (p_source.path.get_extension() == "skel") {
 		sp::SkeletonBinary binary(atlas);
 		binary.setScale(1);
-		skeletonData = binary.readSkeletonDataFile(p_path.utf8().get_data());
+		skeletonData = binary.readSkeletonData(p_source.data.ptr(), p_source.data.size() - 1);
 		err_msg = binary.getError().buffer();
 	}
 
     if (!skeletonData) {
+		if (SpineRuntime::release_atlas(atlas)) delete atlas;
 		ERR_FAIL_V_MSG(Ref<SpineResource>(), err_msg);
     }
     
     resource.instance();
     resource->atlas = atlas;
     resource->data = skeletonData;
+    resource->state_data = new sp::AnimationStateData(skeletonData);
     resource->runtime_version = SPINE_RUNTIME_VERSION_STRING;
+	spine_index_names(resource.ptr(), skeletonData);
+
+	float compression_tolerance = GLOBAL_GET("spine/timelines/compression_tolerance");
+	if (compression_tolerance > 0) {
+		Dictionary report = compress_timelines(resource, compression_tolerance, GLOBAL_GET("spine/timelines/compression_rotation_tolerance"), GLOBAL_GET("spine/timelines/compression_scale_tolerance"));
+		print_verbose(vformat("Spine: %s timelines %d -> %d bytes", p_source.path, report.get("memory_before", 0), report.get("memory_after", 0)));
+	}
+	float dense_fps = GLOBAL_GET("spine/timelines/dense_sampling_fps");
+	if (dense_fps > 0) {
+		bake_timelines(resource, dense_fps, (int)GLOBAL_GET("spine/timelines/dense_sampling_max_memory"), GLOBAL_GET("spine/timelines/dense_sampling_tolerance"));
+	}
     return resource;
 }
 
+// Pages and regions of the source's atlas as a SpineAtlasTable, so cooked
+// skeletons build their atlas without parsing its text. Empty for the 3.x
+// runtimes, whose loads keep parsing it.
+Vector<uint8_t> SPINE_RUNTIME_CLASS::cook_atlas(const SkeletonSource &p_source) {
+	Vector<uint8_t> table_data;
+#ifdef SPINE_RUNTIME_4
+	Vector<uint8_t> atlas_data = SpineRuntime::get_atlas_data(p_source);
+	if (atlas_data.empty()) return table_data;
+	sp::Atlas atlas((const char *)atlas_data.ptr(), atlas_data.size() - 1, "", &spine_texture_loader, false);
+	SpineAtlasTable table;
+	HashMap<uint64_t, int> page_ids;
+	sp::Vector<sp::AtlasPage *> &pages = atlas.getPages();
+	for (size_t i = 0; i < pages.size(); i++) {
+		SpineAtlasTable::Page page;
+		page.name = String::utf8(pages[i]->name.buffer());
+		page.format = pages[i]->format;
+		page.min_filter = pages[i]->minFilter;
+		page.mag_filter = pages[i]->magFilter;
+		page.u_wrap = pages[i]->uWrap;
+		page.v_wrap = pages[i]->vWrap;
+		page.width = pages[i]->width;
+		page.height = pages[i]->height;
+		page.pma = pages[i]->pma;
+		page_ids[(uint64_t)pages[i]] = table.pages.size();
+		table.pages.push_back(page);
+	}
+	sp::Vector<sp::AtlasRegion *> &regions = atlas.getRegions();
+	for (size_t i = 0; i < regions.size(); i++) {
+		sp::AtlasRegion *source = regions[i];
+		SpineAtlasTable::Region region;
+		region.page = page_ids[(uint64_t)source->page];
+		region.name = String::utf8(source->name.buffer());
+		region.x = source->x;
+		region.y = source->y;
+		region.width = source->width;
+		region.height = source->height;
+		region.u = source->u;
+		region.v = source->v;
+		region.u2 = source->u2;
+		region.v2 = source->v2;
+		region.offset_x = source->offsetX;
+		region.offset_y = source->offsetY;
+		region.original_width = source->originalWidth;
+		region.original_height = source->originalHeight;
+		region.index = source->index;
+		region.degrees = source->degrees;
+		for (size_t j = 0; j < source->splits.size(); j++) {
+			region.splits.push_back(source->splits[j]);
+		}
+		for (size_t j = 0; j < source->pads.size(); j++) {
+			region.pads.push_back(source->pads[j]);
+		}
+		table.regions.push_back(region);
+	}
+	if (!table.pages.empty()) {
+		table_data = table.encode();
+	}
+#endif
+	return table_data;
+}
+
+Dictionary SPINE_RUNTIME_CLASS::compress_timelines(Ref<SpineResource> p_res, float p_translate_tolerance, float p_rotate_tolerance, float p_scale_tolerance) {
+	ERR_FAIL_COND_V(p_res.is_null() || !p_res->data, Dictionary());
+#ifdef SPINE_RUNTIME_4
+	p_res->pose_cache.clear();
+	return spine_compress_timelines((sp::SkeletonData*)p_res->data, p_translate_tolerance, p_rotate_tolerance, p_scale_tolerance);
+#else
+	WARN_PRINT("Keyframe compression requires spine runtime 4.0 or newer");
+	return Dictionary();
+#endif
+}
+
+Dictionary SPINE_RUNTIME_CLASS::bake_timelines(Ref<SpineResource> p_res, float p_fps, int p_max_bytes, float p_tolerance) {
+	ERR_FAIL_COND_V(p_res.is_null() || !p_res->data, Dictionary());
+#ifdef SPINE_RUNTIME_4
+	// cached poses were computed by the timelines being replaced
+	p_res->pose_cache.clear();
+	return spine_bake_timelines((sp::SkeletonData*)p_res->data, p_fps, p_max_bytes, p_tolerance);
+#else
+	WARN_PRINT("Dense timeline sampling requires spine runtime 4.0 or newer");
+	return Dictionary();
+#endif
+}
+
+void SPINE_RUNTIME_CLASS::set_resource_mix(Ref<SpineResource> p_res, int p_from, int p_to, float p_duration) {
+	ERR_FAIL_COND(p_res.is_null() || !p_res->state_data);
+	sp::AnimationStateData *state_data = (sp::AnimationStateData*)p_res->state_data;
+	if (p_from < 0 || p_to < 0) {
+		state_data->setDefaultMix(p_duration);
+		return;
+	}
+	sp::Vector<sp::Animation*> &animations = ((sp::SkeletonData*)p_res->data)->getAnimations();
+	ERR_FAIL_INDEX(p_from, (int)animations.size());
+	ERR_FAIL_INDEX(p_to, (int)animations.size());
+	state_data->setMix(animations[p_from], animations[p_to], p_duration);
+}
+
+void SPINE_RUNTIME_CLASS::free_resource(SpineResource *p_res) {
+#if defined(SPINE_RUNTIME_3_8) || defined(SPINE_RUNTIME_4)
+	// composed skins hold references to the data's attachments
+	const String *key = NULL;
+	while ((key = p_res->composed_skins.next(key))) {
+		spine_free_composed_skin((SPINE_COMPOSED_SKIN_CLASS *)p_res->composed_skins[*key]);
+	}
+#endif
+	p_res->composed_skins.clear();
+	if (p_res->state_data) delete (sp::AnimationStateData*)p_res->state_data;
+	if (p_res->data) delete (sp::SkeletonData*)p_res->data;
+	if (p_res->atlas && SpineRuntime::release_atlas(p_res->atlas)) delete (sp::Atlas*)p_res->atlas;
+	p_res->state_data = NULL;
+	p_res->data = NULL;
+	p_res->atlas = NULL;
+}
+
 Ref<SpineRuntime> SPINE_RUNTIME_CLASS::with_resource(Ref<SpineResource> res) {
     if (res.is_null()) { return Ref<SpineRuntime>(); }
     if (!res->data) { return Ref<SpineRuntime>(); }
@@ -271,7 +810,11 @@ SPINE_RUNTIME_CLASS::SPINE_RUNTIME_CLASS(Ref<SpineResource> resource) {
     skeleton = NULL;
     root_bone = NULL;
     clipper = NULL;
+    worn_skin = NULL;
     state = NULL;
+    manual_pose = false;
+    bones_dirty = false;
+    this->resource = resource;
 
     if (resource.is_null())
 		return;
@@ -279,15 +822,25 @@ SPINE_RUNTIME_CLASS::SPINE_RUNTIME_CLASS(Ref<SpineResource> resource) {
 	if (!resource->data) {
         return;
     }
-    world_verts.setSize(2048, 0);
     sp::SkeletonData* data = (sp::SkeletonData*)resource->data;
-	skeleton = new sp::Skeleton(data);
+	SpineAllocator::MeasureScope measure;
+	uint64_t skeleton_bytes;
+	{
+		// bones, slots and constraints live exactly as long as the skeleton
+		SpineAllocator::MeasureScope skeleton_measure;
+		SpineAllocator::ArenaScope scope(&skeleton_arena);
+		skeleton = new sp::Skeleton(data);
+		skeleton_bytes = skeleton_measure.get_bytes();
+	}
 	root_bone = skeleton->getBones()[0];
 	clipper = new sp::SkeletonClipping();
+	dirty_bones.resize(skeleton->getBones().size());
+	memset(dirty_bones.ptrw(), 0, dirty_bones.size());
 
-	state = new sp::AnimationState(new sp::AnimationStateData(data));
+	state = new sp::AnimationState((sp::AnimationStateData*)resource->state_data);
 	state->setRendererObject(this);
 	state->setListener(spine_animation_callback);
+	_set_instance_bytes(measure.get_bytes(), skeleton_bytes);
 }
 
 SPINE_RUNTIME_CLASS::~SPINE_RUNTIME_CLASS() {
@@ -298,22 +851,23 @@ SPINE_RUNTIME_CLASS::~SPINE_RUNTIME_CLASS() {
 	state = NULL;
 	skeleton = NULL;
 	clipper = NULL;
+	_release_worn_skin();
     
-    for (AttachmentNodes::Element *E = attachment_nodes.front(); E; E = E->next()) {
-		AttachmentNode &node = E->get();
-		memdelete(node.ref);
+    while (attachment_nodes.front()) {
+		_detach_node(&attachment_nodes.front()->get());
 	}
-	attachment_nodes.clear();
 }
 
 
 void SPINE_RUNTIME_CLASS::batch(SpineBatcher* batcher, const Color &modulate, bool flip_x, bool flip_y, bool individual_textures) {
+    _update_dirty_bones();
     skeleton->getColor().set(modulate.r, modulate.g, modulate.b, modulate.a);
 
 	int additive = 0;
 	Color color;
 	float *uvs = NULL;
 	int vertices_count = 0;
+	float *world_verts = NULL;
     unsigned short *triangles = NULL;
 	int triangles_count = 0;
 	float r = 0, g = 0, b = 0, a = 0;
@@ -332,6 +886,7 @@ void SPINE_RUNTIME_CLASS::batch(SpineBatcher* batcher, const Color &modulate, bo
         if (slot->getAttachment()->getRTTI().isExactly(sp::RegionAttachment::rtti)) {
 			sp::RegionAttachment* attachment = (sp::RegionAttachment*)slot->getAttachment();
             vertices_count = 8;
+            world_verts = get_scratch_vertices(vertices_count);
 #ifdef SPINE_RUNTIME_3
             attachment->computeWorldVertices(slot->getBone(), world_verts, 0, 2);
 #elifdef SPINE_RUNTIME_4_0
@@ -352,7 +907,8 @@ void SPINE_RUNTIME_CLASS::batch(SpineBatcher* batcher, const Color &modulate, bo
         } else if (slot->getAttachment()->getRTTI().isExactly(sp::MeshAttachment::rtti)) {
 			sp::MeshAttachment* attachment = (sp::MeshAttachment*)slot->getAttachment();
             vertices_count = attachment->getWorldVerticesLength();
-            attachment->computeWorldVertices(*slot, world_verts);
+            world_verts = get_scratch_vertices(vertices_count);
+            attachment->computeWorldVertices(*slot, 0, vertices_count, world_verts, 0, 2);
             texture = spine_get_texture(attachment);
             uvs = attachment->getUVs().buffer();
             triangles = attachment->getTriangles().buffer();
@@ -377,7 +933,7 @@ void SPINE_RUNTIME_CLASS::batch(SpineBatcher* batcher, const Color &modulate, bo
 		color.b = skeleton->getColor().b * slot->getColor().b * b;
 
         if (clipper->isClipping()) {
-            clipper->clipTriangles(world_verts.buffer(), triangles, triangles_count, uvs, 2);
+            clipper->clipTriangles(world_verts, triangles, triangles_count, uvs, 2);
 			if (clipper->getClippedTriangles().size() == 0){
 				clipper->clipEnd(*slot);
 				continue;
@@ -393,7 +949,7 @@ void SPINE_RUNTIME_CLASS::batch(SpineBatcher* batcher, const Color &modulate, bo
             );
 		} else {
 			batcher->add(texture, 
-                world_verts.buffer(), 
+                world_verts, 
                 uvs, 
                 vertices_count, 
                 triangles, 
@@ -409,11 +965,76 @@ void SPINE_RUNTIME_CLASS::batch(SpineBatcher* batcher, const Color &modulate, bo
 	batcher->flush();
 }
 
+// Serves bone world transforms from the resource pose cache for plain
+// single-track playback. Returns false when the caller has to run
+// updateWorldTransform itself; on a miss the computed pose is stored.
+bool SPINE_RUNTIME_CLASS::_apply_cached_pose() {
+	SpinePoseCache &cache = resource->pose_cache;
+	if (!cache.is_enabled() || manual_pose) return false;
+
+	sp::TrackEntry *entry = NULL;
+	sp::Vector<sp::TrackEntry*> &tracks = state->getTracks();
+	for (int i = 0, n = tracks.size(); i < n; i++) {
+		if (tracks[i] == NULL) continue;
+		if (entry != NULL) return false;
+		entry = tracks[i];
+	}
+	if (entry == NULL || entry->getAnimation() == NULL) return false;
+	if (entry->getMixingFrom() != NULL || entry->getAlpha() < 1 || entry->getTrackTime() < 0) return false;
+
+	float time = entry->getTrackTime();
+	float start = entry->getAnimationStart();
+	float end = entry->getAnimationEnd();
+	if (entry->getLoop() && end > start) {
+		time = start + Math::fmod(time, end - start);
+	} else {
+		time = MIN(start + time, end);
+	}
+
+	SpinePoseCache::Key key;
+	key.skin = skeleton->getSkin();
+	key.animation = entry->getAnimation();
+	key.frame = cache.quantize(time);
+
+	sp::Vector<sp::Bone*> &bones = skeleton->getBones();
+	const float *pose = cache.get(key);
+	if (pose != NULL) {
+		for (int i = 0, n = bones.size(); i < n; i++, pose += SpinePoseCache::FLOATS_PER_BONE) {
+			sp::Bone *bone = bones[i];
+			bone->setA(pose[0]);
+			bone->setB(pose[1]);
+			bone->setC(pose[2]);
+			bone->setD(pose[3]);
+			bone->setWorldX(pose[4]);
+			bone->setWorldY(pose[5]);
+		}
+		return true;
+	}
+
+	skeleton->updateWorldTransform();
+	pose_buffer.resize(bones.size() * SpinePoseCache::FLOATS_PER_BONE);
+	float *w = pose_buffer.ptrw();
+	for (int i = 0, n = bones.size(); i < n; i++, w += SpinePoseCache::FLOATS_PER_BONE) {
+		sp::Bone *bone = bones[i];
+		w[0] = bone->getA();
+		w[1] = bone->getB();
+		w[2] = bone->getC();
+		w[3] = bone->getD();
+		w[4] = bone->getWorldX();
+		w[5] = bone->getWorldY();
+	}
+	cache.store(key, pose_buffer.ptr(), pose_buffer.size());
+	return true;
+}
+
 void SPINE_RUNTIME_CLASS::process(float delta) {
     if (state == NULL) return;
     state->update(delta);
     state->apply(*skeleton);
-    skeleton->updateWorldTransform();
+    _clear_dirty_bones();
+    if (!_apply_cached_pose()) {
+        skeleton->updateWorldTransform();
+    }
 
 	// Calculate and draw mesh only if timelines has been changed
 	// String current_state_hash = build_state_hash();
@@ -424,37 +1045,39 @@ void SPINE_RUNTIME_CLASS::process(float delta) {
 	// }
 
 
-	for (AttachmentNodes::Element *E = attachment_nodes.front(); E; E = E->next()) {
+	// followers queued for deletion are detached when they leave the tree,
+	// the others wait outside it until they are added back or turn out to
+	// have been freed
+	for (AttachmentNodes::Element *E = attachment_nodes.front(), *N = NULL; E; E = N) {
+		N = E->next();
 		AttachmentNode &info = E->get();
-		WeakRef *ref = info.ref;
-		Object *obj = ref->get_ref();
-		Node2D *node = (obj != NULL) ? Object::cast_to<Node2D>(obj) : NULL;
-		if (obj == NULL || node == NULL) {
-
-			AttachmentNodes::Element *NEXT = E->next();
-			attachment_nodes.erase(E);
-			E = NEXT;
-			if (E == NULL)
-				break;
+		if (!info.inside) {
+			if (ObjectDB::get_instance(info.node_id) == NULL) {
+				_detach_node(&info);
+			}
 			continue;
 		}
-        sp::Slot *slot = info.slot;
-		sp::Bone bone = slot->getBone();
-		node->call("set_position", Vector2(bone.getWorldX() + bone.getSkeleton().getX(), -bone.getWorldY() + bone.getSkeleton().getY()) + info.ofs);
-		node->call("set_scale", Vector2(bone.getWorldScaleX(), bone.getWorldScaleY()) * info.scale);
-		node->call("set_rotation_degrees", bone.getWorldRotationX() + info.rot);
-        Color c;
-        c.a = slot->getColor().a;
-        c.r = slot->getColor().r;
-        c.g = slot->getColor().g;
-        c.b = slot->getColor().b;
-        node->call("set_modulate", c);
+		sp::Bone *bone = info.bone;
+		Transform2D xform;
+		xform.set_rotation_and_scale(Math::deg2rad(bone->getWorldRotationX() + info.rot), Vector2(bone->getWorldScaleX(), bone->getWorldScaleY()) * info.scale);
+		xform.elements[2] = Vector2(bone->getWorldX() + skeleton->getX(), -bone->getWorldY() + skeleton->getY()) + info.ofs;
+		sp::Color &slot_color = info.slot->getColor();
+		Color color(slot_color.r, slot_color.g, slot_color.b, slot_color.a);
+		if (!info.synced || xform != info.xform) {
+			info.node->set_transform(xform);
+			info.xform = xform;
+		}
+		if (!info.synced || color != info.color) {
+			info.node->set_modulate(color);
+			info.color = color;
+		}
+		info.synced = true;
 	}
 }
 
 float SPINE_RUNTIME_CLASS::get_animation_length(String p_animation) const {
     if (state == NULL) return 0;
-    sp::Animation* animation = state->getData()->getSkeletonData()->findAnimation(p_animation.utf8().get_data());
+    sp::Animation* animation = _find_animation(p_animation);
     if (animation == NULL) {
         return 0;
     } else {
@@ -484,25 +1107,105 @@ Array SPINE_RUNTIME_CLASS::get_skin_names() const {
 
 bool SPINE_RUNTIME_CLASS::has_animation(const String &p_name) {
 	if (skeleton == NULL) return false;
-    return NULL != state->getData()->getSkeletonData()->findAnimation(p_name.utf8().get_data());
+    return NULL != _find_animation(p_name);
 }
 
 bool SPINE_RUNTIME_CLASS::set_skin(const String &p_name) {
     if (skeleton == NULL) return false;
-	skeleton->setSkin(p_name.utf8().get_data());
+	if (p_name.empty()) {
+		skeleton->setSkin((sp::Skin *)NULL);
+		_release_worn_skin();
+		return true;
+	}
+	int skin_id = resource->find_skin_id(p_name);
+	if (skin_id < 0) return false;
+	skeleton->setSkin(skeleton->getData()->getSkins()[skin_id]);
+	_release_worn_skin();
     return true;
 }
 
+// Drops this runtime's hold on the skin set_skins() made it wear.
+void SPINE_RUNTIME_CLASS::_release_worn_skin() {
+#if defined(SPINE_RUNTIME_3_8) || defined(SPINE_RUNTIME_4)
+	if (worn_skin) spine_release_composed_skin(resource.ptr(), (SPINE_COMPOSED_SKIN_CLASS *)worn_skin);
+#endif
+	worn_skin = NULL;
+}
+
+// Wears the skin combining p_skin_ids. The result is cached on the
+// resource per loadout while some runtime wears it, so every instance with
+// the same loadout shares the skin and, when baked, its texture. A failed
+// bake is cached too and only tried again once the maximum size changes.
+bool SPINE_RUNTIME_CLASS::set_skins(const Vector<int> &p_skin_ids, bool p_bake) {
+	if (skeleton == NULL) return false;
+#if defined(SPINE_RUNTIME_3_8) || defined(SPINE_RUNTIME_4)
+	sp::SkeletonData *data = skeleton->getData();
+	String key = p_bake ? "baked" : "composed";
+	for (int i = 0; i < p_skin_ids.size(); i++) {
+		ERR_FAIL_INDEX_V(p_skin_ids[i], (int)data->getSkins().size(), false);
+		key += ":" + itos(p_skin_ids[i]);
+	}
+	SPINE_COMPOSED_SKIN_CLASS *composed = NULL;
+	void **cached = resource->composed_skins.getptr(key);
+	if (cached) {
+		composed = (SPINE_COMPOSED_SKIN_CLASS *)*cached;
+		if (composed->bake_size && composed->bake_size != (int)GLOBAL_GET("spine/skins/max_baked_texture_size")) {
+			// its wearers keep the unbaked skin, new ones get another try
+			resource->composed_skins.erase(key);
+			composed = NULL;
+		}
+	}
+	if (composed == NULL) {
+		composed = spine_compose_skin(data, p_skin_ids, key, p_bake);
+		resource->composed_skins[key] = composed;
+	}
+	composed->users++;
+	skeleton->setSkin(composed->skin);
+	skeleton->setSlotsToSetupPose();
+	_release_worn_skin();
+	worn_skin = composed;
+	return true;
+#else
+	WARN_PRINT("Composing skins requires spine runtime 3.8 or newer");
+	return false;
+#endif
+}
+
 void SPINE_RUNTIME_CLASS::mix(const String &p_from, const String &p_to, real_t p_duration) {
 	if (state == NULL) return;
-    state->getData()->setMix(p_from.utf8().get_data(), p_to.utf8().get_data(), p_duration);
+    sp::Animation *from = _find_animation(p_from);
+    sp::Animation *to = _find_animation(p_to);
+    if (from == NULL || to == NULL) return;
+    _set_mix_override(from, to, p_duration);
+}
+
+sp::TrackEntry *SPINE_RUNTIME_CLASS::_set_animation(int p_track, sp::Animation *p_animation, bool p_loop) {
+	sp::TrackEntry *entry = state->setAnimation(p_track, p_animation, p_loop);
+	if (entry == NULL || mix_overrides.empty() || entry->getMixingFrom() == NULL) return entry;
+	const float *duration = _get_mix_override(entry->getMixingFrom()->getAnimation(), p_animation);
+	if (duration) entry->setMixDuration(*duration);
+	return entry;
+}
+
+sp::TrackEntry *SPINE_RUNTIME_CLASS::_add_animation(int p_track, sp::Animation *p_animation, bool p_loop, float p_delay) {
+	sp::TrackEntry *last = mix_overrides.empty() ? NULL : state->getCurrent(p_track);
+	while (last && last->getNext()) last = last->getNext();
+	sp::TrackEntry *entry = state->addAnimation(p_track, p_animation, p_loop, p_delay);
+	if (entry == NULL || last == NULL) return entry;
+	const float *duration = _get_mix_override(last->getAnimation(), p_animation);
+	if (duration) {
+		// a non-positive delay was resolved against the shared mix duration
+		if (p_delay <= 0) entry->setDelay(MAX(0.0f, entry->getDelay() + entry->getMixDuration() - *duration));
+		entry->setMixDuration(*duration);
+	}
+	return entry;
 }
 
 bool SPINE_RUNTIME_CLASS::play(const String &p_name, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
     if (skeleton == NULL) return false;
-	sp::Animation *animation = skeleton->getData()->findAnimation(p_name.utf8().get_data());
+	sp::Animation *animation = _find_animation(p_name);
 	if (animation == NULL) return false;
-	sp::TrackEntry *entry = state->setAnimation(p_track, animation, p_loop);
+	sp::TrackEntry *entry = _set_animation(p_track, animation, p_loop);
     if (entry == NULL) return false;
 	entry->setDelay(p_delay);
 	entry->setTimeScale(p_cunstom_scale);
@@ -511,18 +1214,18 @@ bool SPINE_RUNTIME_CLASS::play(const String &p_name, real_t p_cunstom_scale, boo
 
 void SPINE_RUNTIME_CLASS::set_animation_state(int p_track, String p_animation, float p_pos) {
 	if (skeleton == NULL) return;
-	sp::Animation *animation = skeleton->getData()->findAnimation(p_animation.utf8().get_data());
+	sp::Animation *animation = _find_animation(p_animation);
 	if (animation == NULL) return;
-	sp::TrackEntry *entry = state->setAnimation(p_track, animation, false);
+	sp::TrackEntry *entry = _set_animation(p_track, animation, false);
     if (entry == NULL) return;
 	entry->setTrackTime(p_pos);
 }
 
 bool SPINE_RUNTIME_CLASS::add(const String &p_name, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
 	if (skeleton == NULL) return false;
-	sp::Animation *animation = skeleton->getData()->findAnimation(p_name.utf8().get_data());
+	sp::Animation *animation = _find_animation(p_name);
 	if (animation == NULL) return false;
-	sp::TrackEntry *entry = state->addAnimation(p_track, animation, p_loop, p_delay);
+	sp::TrackEntry *entry = _add_animation(p_track, animation, p_loop, p_delay);
     if (entry == NULL) return false;
 	return true;
 }
@@ -553,12 +1256,27 @@ String SPINE_RUNTIME_CLASS::get_current_animation(int p_track) const {
 
 void SPINE_RUNTIME_CLASS::reset() {
 	if (skeleton == NULL) return;
+	manual_pose = false;
+	_clear_dirty_bones();
 	skeleton->setToSetupPose();
 	state->update(0);
 	state->apply(*skeleton);
     skeleton->updateWorldTransform();
 }
 
+// Returns the runtime to the state with_resource() left it in.
+void SPINE_RUNTIME_CLASS::recycle() {
+	if (skeleton == NULL) return;
+	while (attachment_nodes.front()) {
+		_detach_node(&attachment_nodes.front()->get());
+	}
+	mix_overrides.clear();
+	state->clearTracks();
+	skeleton->setSkin(NULL);
+	_release_worn_skin();
+	reset();
+}
+
 void SPINE_RUNTIME_CLASS::seek(int track, float p_pos) {
 	if (state == NULL) return;
 	sp::TrackEntry *entry = state->getCurrent(track);
@@ -576,7 +1294,7 @@ float SPINE_RUNTIME_CLASS::tell(int track) const {
 Dictionary SPINE_RUNTIME_CLASS::get_skeleton(bool individual_textures) const {
 	Dictionary dict;
     if (skeleton == NULL) return dict;
-
+	_update_dirty_bones();
 
 	dict["bonesCount"] = (int)skeleton->getBones().size();
 	dict["slotCount"] = (int)skeleton->getSlots().size();
@@ -632,7 +1350,9 @@ Dictionary SPINE_RUNTIME_CLASS::get_skeleton(bool individual_textures) const {
 Dictionary SPINE_RUNTIME_CLASS::get_attachment(const String &p_slot_name, const String &p_attachment_name) const {
 	Dictionary dict;
 	if (skeleton == NULL) return dict;
-	sp::Attachment *attachment = skeleton->getAttachment(p_slot_name.utf8().get_data(), p_attachment_name.utf8().get_data());
+	int slot_id = resource->find_slot_id(p_slot_name);
+	if (slot_id < 0) return dict;
+	sp::Attachment *attachment = skeleton->getAttachment(slot_id, p_attachment_name.utf8().get_data());
 	if (attachment == NULL) return dict;
 	dict["name"] = attachment->getName().buffer();
 	if (attachment->getRTTI().isExactly(sp::RegionAttachment::rtti)) {
@@ -687,8 +1407,9 @@ Dictionary SPINE_RUNTIME_CLASS::get_attachment(const String &p_slot_name, const
 Dictionary SPINE_RUNTIME_CLASS::get_bone(const String &p_bone_name) const {
 	Dictionary dict;
 	if (skeleton == NULL) return dict;
-	sp::Bone *bone = skeleton->findBone(p_bone_name.utf8().get_data());
+	sp::Bone *bone = _find_bone(p_bone_name);
 	if (bone == NULL) return dict;
+	_update_dirty_bones();
 	dict["x"] = bone->getX();
 	dict["y"] = bone->getY();
 	dict["rotation"] = bone->getRotation();
@@ -715,7 +1436,7 @@ Dictionary SPINE_RUNTIME_CLASS::get_bone(const String &p_bone_name) const {
 Dictionary SPINE_RUNTIME_CLASS::get_slot(const String &p_slot_name) const {
     Dictionary dict;
     if (skeleton == NULL) return dict;
-	sp::Slot *slot = skeleton->findSlot(p_slot_name.utf8().get_data());
+	sp::Slot *slot = _find_slot(p_slot_name);
     if (slot == NULL) return dict;
 	dict["color"] = Color(slot->getColor().r, slot->getColor().g, slot->getColor().b, slot->getColor().a);
 	if (slot->getAttachment() == NULL) {
@@ -728,10 +1449,15 @@ Dictionary SPINE_RUNTIME_CLASS::get_slot(const String &p_slot_name) const {
 
 bool SPINE_RUNTIME_CLASS::set_attachment(const String &p_slot_name, const Variant &p_attachment) {
 	if (skeleton == NULL) return false;
-	if (p_attachment.get_type() == Variant::STRING)
-		skeleton->setAttachment(p_slot_name.utf8().get_data(), ((const String)p_attachment).utf8().get_data());
-	else
-		skeleton->setAttachment(p_slot_name.utf8().get_data(), "");
+	int slot_id = resource->find_slot_id(p_slot_name);
+	if (slot_id < 0) return false;
+	sp::Attachment *attachment = NULL;
+	// an empty name clears the slot, like null
+	if (p_attachment.get_type() == Variant::STRING && !((const String)p_attachment).empty()) {
+		attachment = skeleton->getAttachment(slot_id, ((const String)p_attachment).utf8().get_data());
+		if (attachment == NULL) return false;
+	}
+	skeleton->getSlots()[slot_id]->setAttachment(attachment);
     return true;
 }
 
@@ -742,12 +1468,13 @@ bool SPINE_RUNTIME_CLASS::has_attachment_node(const String &p_bone_name, const V
 bool SPINE_RUNTIME_CLASS::add_attachment_node(const String &p_bone_name, const Variant &p_node, const Vector2 &p_ofs, const Vector2 &p_scale, const real_t p_rot) {
 
 	if (skeleton == NULL) return false;
-	sp::Slot *slot = skeleton->findSlot(p_bone_name.utf8().get_data());
+	sp::Slot *slot = _find_slot(p_bone_name);
     if (slot == NULL) return false;
 	Object *obj = p_node;
     if (obj == NULL) return false;
 	Node2D *node = Object::cast_to<Node2D>(obj);
 	if (node == NULL) return false;
+	ERR_FAIL_COND_V_MSG(!node->is_inside_tree(), false, "Attachment node must be inside the scene tree");
 
 	if (obj->has_meta("spine_meta")) {
 
@@ -767,19 +1494,24 @@ bool SPINE_RUNTIME_CLASS::add_attachment_node(const String &p_bone_name, const V
 	AttachmentNode &info = attachment_nodes.back()->get();
 	info.E = attachment_nodes.back();
 	info.slot = slot;
-	info.ref = memnew(WeakRef);
-	info.ref->set_obj(node);
+	info.bone = &slot->getBone();
+	info.node = node;
 	info.ofs = p_ofs;
 	info.scale = p_scale;
 	info.rot = p_rot;
+	info.node_id = node->get_instance_id();
+	info.synced = false;
+	info.inside = true;
 	obj->set_meta("spine_meta", (uint64_t)&info);
+	node->connect("tree_exiting", this, "_on_attachment_node_exiting", varray(node));
+	node->connect("tree_entered", this, "_on_attachment_node_entered", varray(node));
 
 	return true;
 }
 
 bool SPINE_RUNTIME_CLASS::remove_attachment_node(const String &p_bone_name, const Variant &p_node) {
     if (skeleton == NULL) return false;
-	sp::Slot *slot = skeleton->findSlot(p_bone_name.utf8().get_data());
+	sp::Slot *slot = _find_slot(p_bone_name);
     if (slot == NULL) return false;
 	Object *obj = p_node;
     if (obj == NULL) return false;
@@ -791,16 +1523,47 @@ bool SPINE_RUNTIME_CLASS::remove_attachment_node(const String &p_bone_name, cons
 
 	AttachmentNode *info = (AttachmentNode *)((uint64_t)obj->get_meta("spine_meta"));
 	if (info->slot != slot) return  false;
-	obj->set_meta("spine_meta", Variant());
-	memdelete(info->ref);
-	attachment_nodes.erase(info->E);
+	_detach_node(info);
 	return false;
 }
 
+void SPINE_RUNTIME_CLASS::_detach_node(AttachmentNode *p_info) {
+	Node2D *node = p_info->node;
+	// a follower freed with free() while out of the tree is gone already
+	if (ObjectDB::get_instance(p_info->node_id) == node) {
+		node->set_meta("spine_meta", Variant());
+		node->disconnect("tree_exiting", this, "_on_attachment_node_exiting");
+		node->disconnect("tree_entered", this, "_on_attachment_node_entered");
+	}
+	attachment_nodes.erase(p_info->E);
+}
+
+// Reparenting the follower, or the Spine node it is a child of, keeps it
+// attached; a follower queued for deletion is detached right away, one
+// freed with free() by the next process(), as it is still alive here.
+void SPINE_RUNTIME_CLASS::_on_attachment_node_exiting(Object *p_node) {
+	if (!p_node->has_meta("spine_meta")) return;
+	AttachmentNode *info = (AttachmentNode *)((uint64_t)p_node->get_meta("spine_meta"));
+	if (p_node->is_queued_for_deletion()) {
+		_detach_node(info);
+	} else {
+		info->inside = false;
+	}
+}
+
+void SPINE_RUNTIME_CLASS::_on_attachment_node_entered(Object *p_node) {
+	if (!p_node->has_meta("spine_meta")) return;
+	AttachmentNode *info = (AttachmentNode *)((uint64_t)p_node->get_meta("spine_meta"));
+	info->inside = true;
+	info->synced = false;
+}
+
 // this looks scary
 Ref<Shape2D> SPINE_RUNTIME_CLASS::get_bounding_box(const String& p_slot_name, const String& p_attachment_name) {
     if (skeleton == NULL) return Ref<Shape2D>();
-	sp::Attachment *attachment = skeleton->getAttachment(p_slot_name.utf8().get_data(), p_attachment_name.utf8().get_data());
+	int slot_id = resource->find_slot_id(p_slot_name);
+	if (slot_id < 0) return Ref<Shape2D>();
+	sp::Attachment *attachment = skeleton->getAttachment(slot_id, p_attachment_name.utf8().get_data());
 	if (attachment == NULL) return Ref<Shape2D>();
 	if (attachment->getRTTI().isExactly(sp::BoundingBoxAttachment::rtti)) return Ref<Shape2D>();
     sp::BoundingBoxAttachment *box = (sp::BoundingBoxAttachment*)attachment;
@@ -830,12 +1593,74 @@ bool SPINE_RUNTIME_CLASS::add_bounding_box(const String &p_bone_name, const Stri
 }
 
 Vector2 SPINE_RUNTIME_CLASS::get_bone_position(const String &bone_name) {
-    sp::Bone *bone = skeleton->findBone(bone_name.utf8().get_data());
+    sp::Bone *bone = _find_bone(bone_name);
     if (bone == NULL) return Vector2();
     return Vector2(bone->getX(), bone->getY());
 }
 float SPINE_RUNTIME_CLASS::get_bone_rotation(const String &bone_name) {
-    sp::Bone *bone = skeleton->findBone(bone_name.utf8().get_data());
+    sp::Bone *bone = _find_bone(bone_name);
     if (bone == NULL) return 0.0;
     return bone->getRotation();
-}
\ No newline at end of file
+}
+
+// Overrides local position and rotation of many bones at once, followed by
+// a single world transform pass. Either array may be empty to leave that
+// channel untouched.
+bool SPINE_RUNTIME_CLASS::set_bones_local(const PoolIntArray &p_bone_ids, const PoolVector2Array &p_positions, const PoolRealArray &p_rotations) {
+	if (skeleton == NULL) return false;
+	int count = p_bone_ids.size();
+	ERR_FAIL_COND_V(p_positions.size() != 0 && p_positions.size() != count, false);
+	ERR_FAIL_COND_V(p_rotations.size() != 0 && p_rotations.size() != count, false);
+
+	sp::Vector<sp::Bone*> &bones = skeleton->getBones();
+	int bones_count = bones.size();
+	PoolIntArray::Read ids = p_bone_ids.read();
+	PoolVector2Array::Read positions = p_positions.read();
+	PoolRealArray::Read rotations = p_rotations.read();
+	for (int i = 0; i < count; i++) {
+		ERR_CONTINUE(ids[i] < 0 || ids[i] >= bones_count);
+		sp::Bone *bone = bones[ids[i]];
+		if (p_positions.size()) {
+			bone->setX(positions[i].x);
+			bone->setY(positions[i].y);
+		}
+		if (p_rotations.size()) {
+			bone->setRotation(rotations[i]);
+		}
+		_mark_bone_dirty(bone);
+	}
+	manual_pose = true;
+	_update_dirty_bones();
+	return true;
+}
+
+bool SPINE_RUNTIME_CLASS::play_id(int p_animation_id, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
+	if (skeleton == NULL) return false;
+	sp::Vector<sp::Animation*> &animations = skeleton->getData()->getAnimations();
+	ERR_FAIL_INDEX_V(p_animation_id, (int)animations.size(), false);
+	sp::TrackEntry *entry = _set_animation(p_track, animations[p_animation_id], p_loop);
+	if (entry == NULL) return false;
+	entry->setDelay(p_delay);
+	entry->setTimeScale(p_cunstom_scale);
+	return true;
+}
+
+bool SPINE_RUNTIME_CLASS::add_id(int p_animation_id, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
+	if (skeleton == NULL) return false;
+	sp::Vector<sp::Animation*> &animations = skeleton->getData()->getAnimations();
+	ERR_FAIL_INDEX_V(p_animation_id, (int)animations.size(), false);
+	sp::TrackEntry *entry = _add_animation(p_track, animations[p_animation_id], p_loop, p_delay);
+	if (entry == NULL) return false;
+	entry->setTimeScale(p_cunstom_scale);
+	return true;
+}
+
+// Bone world transform in node space (y axis pointing down).
+Transform2D SPINE_RUNTIME_CLASS::get_bone_world_by_id(int p_bone_id) const {
+	if (skeleton == NULL) return Transform2D();
+	sp::Vector<sp::Bone*> &bones = skeleton->getBones();
+	ERR_FAIL_INDEX_V(p_bone_id, (int)bones.size(), Transform2D());
+	_update_dirty_bones();
+	sp::Bone *bone = bones[p_bone_id];
+	return Transform2D(bone->getA(), -bone->getC(), -bone->getB(), bone->getD(), bone->getWorldX(), -bone->getWorldY());
+}
@@ -0,0 +1,481 @@
+// Timeline post-processing shared by spine-cpp runtimes. Included from
+// common_runtime.impl.cpp, so `sp` and SPINE_RUNTIME_* are already defined.
+// It is compiled once per runtime: classes carry the runtime in their name
+// and everything else is static, including the dense timeline registry.
+
+#ifdef SPINE_RUNTIME_4
+
+// mirrors CurveTimeline constants of spine-cpp 4.x
+#define SPINE_CURVE_LINEAR 0
+#define SPINE_CURVE_STEPPED 1
+#define SPINE_CURVE_BEZIER 2
+#define SPINE_CURVE_BEZIER_SIZE 18
+
+// Returns the index of the frame preceding `p_time`, scanning forward from
+// `p_frame`. Callers sampling in time order pass the previous result back,
+// so a full resample walks the frames once.
+static int spine_curve_seek(sp::CurveTimeline *p_timeline, float p_time, int p_frame) {
+	sp::Vector<float> &frames = p_timeline->getFrames();
+	int entries = p_timeline->getFrameEntries();
+	int n = frames.size();
+	int i = p_frame;
+	for (int j = i + entries; j < n; j += entries) {
+		if (frames[j] > p_time) break;
+		i = j;
+	}
+	return i;
+}
+
+// Stock curve evaluation of value `p_value` of a CurveTimeline1/2 at `p_time`
+// in the segment starting at frame index `p_frame`, same math as
+// CurveTimeline::getBezierValue and the linear branches of apply().
+static float spine_curve_value(sp::CurveTimeline *p_timeline, int p_frame, float p_time, int p_value) {
+	sp::Vector<float> &frames = p_timeline->getFrames();
+	sp::Vector<float> &curves = p_timeline->getCurves();
+	int entries = p_timeline->getFrameEntries();
+	int n = frames.size();
+	int offset = 1 + p_value;
+	int i = p_frame;
+
+	int curve_type = (int)curves[i / entries];
+	if (i + entries >= n || curve_type == SPINE_CURVE_STEPPED) {
+		return frames[i + offset];
+	}
+	if (curve_type == SPINE_CURVE_LINEAR) {
+		float before = frames[i];
+		float value = frames[i + offset];
+		float t = (p_time - before) / (frames[i + entries] - before);
+		return value + (frames[i + entries + offset] - value) * t;
+	}
+
+	int b = curve_type - SPINE_CURVE_BEZIER + p_value * SPINE_CURVE_BEZIER_SIZE;
+	if (curves[b] > p_time) {
+		float x = frames[i], y = frames[i + offset];
+		return y + (p_time - x) / (curves[b] - x) * (curves[b + 1] - y);
+	}
+	int end = b + SPINE_CURVE_BEZIER_SIZE;
+	for (b += 2; b < end; b += 2) {
+		if (curves[b] >= p_time) {
+			float x = curves[b - 2], y = curves[b - 1];
+			return y + (p_time - x) / (curves[b] - x) * (curves[b + 1] - y);
+		}
+	}
+	float x = curves[end - 2], y = curves[end - 1];
+	return y + (p_time - x) / (frames[i + entries] - x) * (frames[i + entries + offset] - y);
+}
+
+static bool spine_curve_has_stepped(sp::CurveTimeline *p_timeline) {
+	sp::Vector<float> &curves = p_timeline->getCurves();
+	for (int i = 0, n = (int)p_timeline->getFrameCount() - 1; i < n; i++) {
+		if ((int)curves[i] == SPINE_CURVE_STEPPED) return true;
+	}
+	return false;
+}
+
+static bool spine_curve_has_bezier(sp::CurveTimeline *p_timeline) {
+	sp::Vector<float> &curves = p_timeline->getCurves();
+	for (int i = 0, n = (int)p_timeline->getFrameCount() - 1; i < n; i++) {
+		if ((int)curves[i] >= SPINE_CURVE_BEZIER) return true;
+	}
+	return false;
+}
+
+static float spine_sign(float p_value) {
+	return p_value < 0 ? -1.0f : (p_value > 0 ? 1.0f : 0.0f);
+}
+
+// Bone blending of spine-cpp 4.x translate, rotate and shear timelines.
+static float spine_blend_value(float p_current, float p_setup, float p_value, float p_alpha, sp::MixBlend p_blend) {
+	switch (p_blend) {
+		case sp::MixBlend_Setup:
+			return p_setup + p_value * p_alpha;
+		case sp::MixBlend_First:
+		case sp::MixBlend_Replace:
+			return p_current + (p_setup + p_value - p_current) * p_alpha;
+		default: // MixBlend_Add
+			return p_current + p_value * p_alpha;
+	}
+}
+
+// Bone blending of spine-cpp 4.x scale timelines, where keys are relative to
+// the setup scale and mixing out keeps the sign of the current scale.
+static float spine_blend_scale(float p_current, float p_setup, float p_value, float p_alpha, sp::MixBlend p_blend, sp::MixDirection p_direction) {
+	float x = p_value * p_setup;
+	if (p_alpha == 1) {
+		return p_blend == sp::MixBlend_Add ? p_current + x - p_setup : x;
+	}
+	if (p_blend == sp::MixBlend_Add) {
+		return p_current + (x - p_setup) * p_alpha;
+	}
+	float from = p_blend == sp::MixBlend_Setup ? p_setup : p_current;
+	if (p_direction == sp::MixDirection_Out) {
+		return from + (ABS(x) * spine_sign(from) - from) * p_alpha;
+	}
+	from = ABS(from) * spine_sign(x);
+	return from + (x - from) * p_alpha;
+}
+
+#define SPINE_BLEND(SET, GET, VALUE) \
+	p_bone->SET(spine_blend_value(p_bone->GET(), p_bone->getData().GET(), VALUE, p_alpha, p_blend))
+#define SPINE_BLEND_SCALE(SET, GET, VALUE) \
+	p_bone->SET(spine_blend_scale(p_bone->GET(), p_bone->getData().GET(), VALUE, p_alpha, p_blend, p_direction))
+
+// Applies an interpolated sample to the bone, picked by timeline type.
+#define SPINE_DENSE_APPLY(T) \
+	static void spine_dense_apply(sp::T *, sp::Bone *p_bone, const float *p_values, float p_alpha, sp::MixBlend p_blend, sp::MixDirection p_direction)
+
+SPINE_DENSE_APPLY(RotateTimeline) { SPINE_BLEND(setRotation, getRotation, p_values[0]); }
+SPINE_DENSE_APPLY(TranslateTimeline) {
+	SPINE_BLEND(setX, getX, p_values[0]);
+	SPINE_BLEND(setY, getY, p_values[1]);
+}
+SPINE_DENSE_APPLY(TranslateXTimeline) { SPINE_BLEND(setX, getX, p_values[0]); }
+SPINE_DENSE_APPLY(TranslateYTimeline) { SPINE_BLEND(setY, getY, p_values[0]); }
+SPINE_DENSE_APPLY(ScaleTimeline) {
+	SPINE_BLEND_SCALE(setScaleX, getScaleX, p_values[0]);
+	SPINE_BLEND_SCALE(setScaleY, getScaleY, p_values[1]);
+}
+SPINE_DENSE_APPLY(ScaleXTimeline) { SPINE_BLEND_SCALE(setScaleX, getScaleX, p_values[0]); }
+SPINE_DENSE_APPLY(ScaleYTimeline) { SPINE_BLEND_SCALE(setScaleY, getScaleY, p_values[0]); }
+SPINE_DENSE_APPLY(ShearTimeline) {
+	SPINE_BLEND(setShearX, getShearX, p_values[0]);
+	SPINE_BLEND(setShearY, getShearY, p_values[1]);
+}
+SPINE_DENSE_APPLY(ShearXTimeline) { SPINE_BLEND(setShearX, getShearX, p_values[0]); }
+SPINE_DENSE_APPLY(ShearYTimeline) { SPINE_BLEND(setShearY, getShearY, p_values[0]); }
+
+#undef SPINE_DENSE_APPLY
+#undef SPINE_BLEND_SCALE
+#undef SPINE_BLEND
+
+// Dense timelines keep the stock RTTI, so they are told apart by address.
+static Set<sp::Timeline *> dense_timelines;
+static Mutex dense_timelines_mutex;
+
+static bool spine_is_dense(sp::Timeline *p_timeline) {
+	MutexLock lock(dense_timelines_mutex);
+	return dense_timelines.has(p_timeline);
+}
+
+// Bone timeline with its curve resampled to a fixed step. It keeps a full
+// copy of the stock frames (and the stock RTTI), so AnimationState paths that
+// read frames directly, such as rotation mixing, behave exactly as before.
+// apply() picks the sample pair in O(1), interpolates it on the stack and
+// blends the result into the bone; the timeline itself is never written, so
+// skeletons sharing the data may update concurrently.
+template <class T>
+class SPINE_DENSE_TIMELINE_CLASS : public T {
+	Vector<float> samples;
+	int values;
+	int sample_count;
+	float start;
+	float step;
+
+	static size_t _bezier_count(T *p_source) {
+		return (p_source->getCurves().size() - p_source->getFrameCount()) / SPINE_CURVE_BEZIER_SIZE;
+	}
+
+public:
+	virtual void apply(sp::Skeleton &skeleton, float lastTime, float time, sp::Vector<sp::Event *> *pEvents, float alpha, sp::MixBlend blend, sp::MixDirection direction) {
+		if (time < start) {
+			T::apply(skeleton, lastTime, time, pEvents, alpha, blend, direction);
+			return;
+		}
+		sp::Bone *bone = skeleton.getBones()[this->getBoneIndex()];
+		if (!bone->isActive()) return;
+
+		float pose[2];
+		const float *s = samples.ptr();
+		float position = (time - start) / step;
+		int i = (int)position;
+		if (i >= sample_count - 1) {
+			// hold the last key
+			for (int v = 0; v < values; v++) {
+				pose[v] = s[(sample_count - 1) * values + v];
+			}
+		} else {
+			float t = position - i;
+			for (int v = 0; v < values; v++) {
+				float from = s[i * values + v];
+				pose[v] = from + (s[(i + 1) * values + v] - from) * t;
+			}
+		}
+		spine_dense_apply((T *)this, bone, pose, alpha, blend, direction);
+	}
+
+	int get_memory_usage() const {
+		return samples.size() * sizeof(float);
+	}
+
+	SPINE_DENSE_TIMELINE_CLASS(T *p_source, int p_sample_count) :
+			T(p_source->getFrameCount(), _bezier_count(p_source), p_source->getBoneIndex()) {
+		sp::Vector<float> &src_frames = p_source->getFrames();
+		sp::Vector<float> &dst_frames = this->getFrames();
+		for (size_t i = 0; i < src_frames.size(); i++) dst_frames[i] = src_frames[i];
+		sp::Vector<float> &src_curves = p_source->getCurves();
+		sp::Vector<float> &dst_curves = this->getCurves();
+		for (size_t i = 0; i < src_curves.size(); i++) dst_curves[i] = src_curves[i];
+
+		values = p_source->getFrameEntries() - 1;
+		sample_count = p_sample_count;
+		start = src_frames[0];
+		float end = src_frames[src_frames.size() - p_source->getFrameEntries()];
+		step = (end - start) / (sample_count - 1);
+
+		samples.resize(sample_count * values);
+		float *w = samples.ptrw();
+		int frame = 0;
+		for (int i = 0; i < sample_count; i++) {
+			float time = i == sample_count - 1 ? end : start + step * i;
+			frame = spine_curve_seek(p_source, time, frame);
+			for (int v = 0; v < values; v++) {
+				*w++ = spine_curve_value(p_source, frame, time, v);
+			}
+		}
+
+		MutexLock lock(dense_timelines_mutex);
+		dense_timelines.insert(this);
+	}
+
+	virtual ~SPINE_DENSE_TIMELINE_CLASS() {
+		MutexLock lock(dense_timelines_mutex);
+		dense_timelines.erase(this);
+	}
+};
+
+static float spine_bone_pose_distance(sp::Bone *p_a, sp::Bone *p_b) {
+	float d = ABS(p_a->getRotation() - p_b->getRotation());
+	d = MAX(d, ABS(p_a->getX() - p_b->getX()));
+	d = MAX(d, ABS(p_a->getY() - p_b->getY()));
+	d = MAX(d, ABS(p_a->getScaleX() - p_b->getScaleX()));
+	d = MAX(d, ABS(p_a->getScaleY() - p_b->getScaleY()));
+	d = MAX(d, ABS(p_a->getShearX() - p_b->getShearX()));
+	d = MAX(d, ABS(p_a->getShearY() - p_b->getShearY()));
+	return d;
+}
+
+// Applies both timelines with setup blending on two scratch skeletons at
+// every sample and midpoint, returning the largest local pose difference.
+static float spine_verify_timeline(sp::Timeline *p_stock, sp::Timeline *p_dense, int p_bone, sp::Skeleton &p_a, sp::Skeleton &p_b, float p_start, float p_end, int p_sample_count) {
+	float worst = 0;
+	float step = (p_end - p_start) / (p_sample_count - 1);
+	for (int i = 0; i < p_sample_count * 2 - 1; i++) {
+		float time = MIN(p_start + step * 0.5 * i, p_end);
+		p_a.setBonesToSetupPose();
+		p_b.setBonesToSetupPose();
+		p_stock->apply(p_a, time, time, NULL, 1, sp::MixBlend_Setup, sp::MixDirection_In);
+		p_dense->apply(p_b, time, time, NULL, 1, sp::MixBlend_Setup, sp::MixDirection_In);
+		worst = MAX(worst, spine_bone_pose_distance(p_a.getBones()[p_bone], p_b.getBones()[p_bone]));
+	}
+	return worst;
+}
+
+template <class T>
+static sp::Timeline *spine_make_dense(sp::Timeline *p_timeline, float p_fps, int &r_budget, float p_tolerance, sp::Skeleton &p_a, sp::Skeleton &p_b, Dictionary &r_report) {
+	T *timeline = (T *)p_timeline;
+	int frame_count = timeline->getFrameCount();
+	if (frame_count < 2 || spine_curve_has_stepped(timeline)) return NULL;
+	// all-linear timelines with few keys are already cheap to search
+	if (!spine_curve_has_bezier(timeline) && frame_count <= 8) return NULL;
+
+	sp::Vector<float> &frames = timeline->getFrames();
+	float start = frames[0];
+	float end = frames[frames.size() - timeline->getFrameEntries()];
+	if (end <= start) return NULL;
+
+	int sample_count = (int)Math::ceil((end - start) * p_fps) + 1;
+	int bytes = sample_count * (timeline->getFrameEntries() - 1) * sizeof(float);
+	if (bytes > r_budget) return NULL;
+
+	SPINE_DENSE_TIMELINE_CLASS<T> *dense = new SPINE_DENSE_TIMELINE_CLASS<T>(timeline, sample_count);
+	float error = spine_verify_timeline(timeline, dense, timeline->getBoneIndex(), p_a, p_b, start, end, sample_count);
+	r_report["max_error"] = MAX((float)r_report["max_error"], error);
+	if (error > p_tolerance) {
+		r_report["rejected"] = (int)r_report["rejected"] + 1;
+		delete dense;
+		return NULL;
+	}
+	r_budget -= dense->get_memory_usage();
+	r_report["memory"] = (int)r_report["memory"] + dense->get_memory_usage();
+	return dense;
+}
+
+#define SPINE_DENSE_TIMELINE(T) \
+	if (timeline->getRTTI().isExactly(sp::T::rtti)) dense = spine_make_dense<sp::T>(timeline, p_fps, budget, p_tolerance, scratch_a, scratch_b, report);
+
+static Dictionary spine_bake_timelines(sp::SkeletonData *p_data, float p_fps, int p_max_bytes, float p_tolerance) {
+	Dictionary report;
+	report["timelines"] = 0;
+	report["rejected"] = 0;
+	report["memory"] = 0;
+	report["max_error"] = 0.0;
+	ERR_FAIL_COND_V(p_fps <= 0, report);
+
+	sp::Skeleton scratch_a(p_data);
+	sp::Skeleton scratch_b(p_data);
+	sp::Vector<sp::Animation*> &animations = p_data->getAnimations();
+	for (int a = 0; a < animations.size(); a++) {
+		int budget = p_max_bytes;
+		sp::Vector<sp::Timeline*> &timelines = animations[a]->getTimelines();
+		for (int t = 0; t < timelines.size(); t++) {
+			sp::Timeline *timeline = timelines[t];
+			if (spine_is_dense(timeline)) continue;
+			sp::Timeline *dense = NULL;
+			SPINE_DENSE_TIMELINE(RotateTimeline)
+			else SPINE_DENSE_TIMELINE(TranslateTimeline)
+			else SPINE_DENSE_TIMELINE(TranslateXTimeline)
+			else SPINE_DENSE_TIMELINE(TranslateYTimeline)
+			else SPINE_DENSE_TIMELINE(ScaleTimeline)
+			else SPINE_DENSE_TIMELINE(ScaleXTimeline)
+			else SPINE_DENSE_TIMELINE(ScaleYTimeline)
+			else SPINE_DENSE_TIMELINE(ShearTimeline)
+			else SPINE_DENSE_TIMELINE(ShearXTimeline)
+			else SPINE_DENSE_TIMELINE(ShearYTimeline)
+			if (dense == NULL) continue;
+			timelines[t] = dense;
+			delete timeline;
+			report["timelines"] = (int)report["timelines"] + 1;
+		}
+	}
+	return report;
+}
+
+#undef SPINE_DENSE_TIMELINE
+
+static int spine_timeline_memory(sp::Timeline *p_timeline) {
+	int floats = p_timeline->getFrames().size();
+	if (p_timeline->getRTTI().instanceOf(sp::CurveTimeline::rtti)) {
+		floats += ((sp::CurveTimeline *)p_timeline)->getCurves().size();
+	}
+	return floats * sizeof(float);
+}
+
+static int spine_timelines_memory(sp::SkeletonData *p_data, int &r_keys) {
+	int bytes = 0;
+	r_keys = 0;
+	sp::Vector<sp::Animation*> &animations = p_data->getAnimations();
+	for (int a = 0; a < animations.size(); a++) {
+		sp::Vector<sp::Timeline*> &timelines = animations[a]->getTimelines();
+		for (int t = 0; t < timelines.size(); t++) {
+			bytes += spine_timeline_memory(timelines[t]);
+			r_keys += timelines[t]->getFrameCount();
+		}
+	}
+	return bytes;
+}
+
+// Returns true when every value of key `p_key` lies within p_tolerance of the
+// line between keys `p_from` and `p_to`.
+static bool spine_key_on_line(sp::Vector<float> &p_frames, int p_entries, int p_from, int p_key, int p_to, float p_tolerance) {
+	float t0 = p_frames[p_from * p_entries];
+	float t = (p_frames[p_key * p_entries] - t0) / (p_frames[p_to * p_entries] - t0);
+	for (int v = 1; v < p_entries; v++) {
+		float from = p_frames[p_from * p_entries + v];
+		float to = p_frames[p_to * p_entries + v];
+		if (ABS(from + (to - from) * t - p_frames[p_key * p_entries + v]) > p_tolerance) return false;
+	}
+	return true;
+}
+
+// Drops keys that the linear interpolation of their kept neighbours
+// reproduces within p_tolerance and rebuilds the timeline at its reduced
+// size. Only keys between two linear segments are candidates, so stepped
+// and bezier segments (and their curve data) survive untouched.
+template <class T>
+static sp::Timeline *spine_reduce_timeline(sp::Timeline *p_timeline, float p_tolerance) {
+	T *timeline = (T *)p_timeline;
+	sp::Vector<float> &frames = timeline->getFrames();
+	sp::Vector<float> &curves = timeline->getCurves();
+	int entries = timeline->getFrameEntries();
+	int count = timeline->getFrameCount();
+	if (count < 3) return NULL;
+
+	Vector<int> kept;
+	kept.push_back(0);
+	int anchor = 0;
+	for (int k = 1; k < count - 1; k++) {
+		bool removable = (int)curves[k - 1] == SPINE_CURVE_LINEAR && (int)curves[k] == SPINE_CURVE_LINEAR;
+		for (int j = anchor + 1; removable && j <= k; j++) {
+			removable = spine_key_on_line(frames, entries, anchor, j, k + 1, p_tolerance);
+		}
+		if (!removable) {
+			kept.push_back(k);
+			anchor = k;
+		}
+	}
+	kept.push_back(count - 1);
+	if (kept.size() == count) return NULL;
+
+	int new_count = kept.size();
+	int bezier_floats = curves.size() - count;
+	T *reduced = new T(new_count, bezier_floats / SPINE_CURVE_BEZIER_SIZE, timeline->getBoneIndex());
+	sp::Vector<float> &new_frames = reduced->getFrames();
+	sp::Vector<float> &new_curves = reduced->getCurves();
+	for (int m = 0; m < new_count; m++) {
+		int k = kept[m];
+		for (int e = 0; e < entries; e++) {
+			new_frames[m * entries + e] = frames[k * entries + e];
+		}
+		// bezier types hold the absolute offset of their data, which moves down
+		// by the number of removed keys
+		int type = (int)curves[k];
+		new_curves[m] = type >= SPINE_CURVE_BEZIER ? type - (count - new_count) : type;
+	}
+	for (int i = 0; i < bezier_floats; i++) {
+		new_curves[new_count + i] = curves[count + i];
+	}
+	return reduced;
+}
+
+#define SPINE_REDUCE_TIMELINE(T, TOLERANCE) \
+	if (timeline->getRTTI().isExactly(sp::T::rtti)) reduced = spine_reduce_timeline<sp::T>(timeline, TOLERANCE);
+
+static Dictionary spine_compress_timelines(sp::SkeletonData *p_data, float p_translate_tolerance, float p_rotate_tolerance, float p_scale_tolerance) {
+	Dictionary report;
+	int keys = 0;
+	report["memory_before"] = spine_timelines_memory(p_data, keys);
+	report["keys_before"] = keys;
+
+	int timelines_reduced = 0;
+	int dense_skipped = 0;
+	sp::Vector<sp::Animation*> &animations = p_data->getAnimations();
+	for (int a = 0; a < animations.size(); a++) {
+		sp::Vector<sp::Timeline*> &timelines = animations[a]->getTimelines();
+		for (int t = 0; t < timelines.size(); t++) {
+			sp::Timeline *timeline = timelines[t];
+			// rebuilding a dense timeline as a stock one would drop its samples
+			if (spine_is_dense(timeline)) {
+				dense_skipped++;
+				continue;
+			}
+			sp::Timeline *reduced = NULL;
+			SPINE_REDUCE_TIMELINE(RotateTimeline, p_rotate_tolerance)
+			else SPINE_REDUCE_TIMELINE(TranslateTimeline, p_translate_tolerance)
+			else SPINE_REDUCE_TIMELINE(TranslateXTimeline, p_translate_tolerance)
+			else SPINE_REDUCE_TIMELINE(TranslateYTimeline, p_translate_tolerance)
+			else SPINE_REDUCE_TIMELINE(ScaleTimeline, p_scale_tolerance)
+			else SPINE_REDUCE_TIMELINE(ScaleXTimeline, p_scale_tolerance)
+			else SPINE_REDUCE_TIMELINE(ScaleYTimeline, p_scale_tolerance)
+			else SPINE_REDUCE_TIMELINE(ShearTimeline, p_rotate_tolerance)
+			else SPINE_REDUCE_TIMELINE(ShearXTimeline, p_rotate_tolerance)
+			else SPINE_REDUCE_TIMELINE(ShearYTimeline, p_rotate_tolerance)
+			if (reduced == NULL) continue;
+			timelines[t] = reduced;
+			delete timeline;
+			timelines_reduced++;
+		}
+	}
+
+	report["memory_after"] = spine_timelines_memory(p_data, keys);
+	report["keys_after"] = keys;
+	report["timelines"] = timelines_reduced;
+	report["dense_skipped"] = dense_skipped;
+	if (dense_skipped > 0) {
+		WARN_PRINT(vformat("Spine: %d dense timelines left uncompressed, compress before baking", dense_skipped));
+	}
+	return report;
+}
+
+#undef SPINE_REDUCE_TIMELINE
+
+#endif // SPINE_RUNTIME_4
@@ -15,33 +15,23 @@
 typedef Ref<Texture> TextureRef;
 typedef Ref<ImageTexture> ImageTextureRef;
 
+// set while cook_atlas() parses an atlas, which needs no textures
+static thread_local bool spine_cooking_atlas = false;
+
 void _spAtlasPage_createTexture(spAtlasPage* self, const char* path) {
-	TextureRef *ref = memnew(TextureRef);
-	*ref = ResourceLoader::load(path);
-	if (!ref->is_null()){
-		self->rendererObject = ref;
-		self->width = (*ref)->get_width();
-		self->height = (*ref)->get_height();
-	} else {
-		memdelete(ref);
-		Ref<Image> img = memnew(Image);
-		if (img->load(path) == OK){
-			ImageTextureRef *imgtex = memnew(ImageTextureRef);
-			(*imgtex) = Ref<ImageTexture>(memnew(ImageTexture));
-			(*imgtex)->create_from_image(img);
-			self->rendererObject = imgtex;
-			self->width = (*imgtex)->get_width();
-			self->height = (*imgtex)->get_height();
-		} else {
-			ERR_FAIL();
-		}
-	}
+	if (spine_cooking_atlas) return;
+	int width = self->width, height = self->height;
+	SpinePage *page = SpineRuntime::load_page(String::utf8(path), &width, &height);
+	ERR_FAIL_COND(!page);
+	self->rendererObject = page;
+	self->width = width;
+	self->height = height;
 }
 
 void _spAtlasPage_disposeTexture(spAtlasPage* self) {
 
-	if(TextureRef *ref = static_cast<TextureRef *>(self->rendererObject))
-		memdelete(ref);
+	if(SpinePage *page = static_cast<SpinePage *>(self->rendererObject))
+		SpineRuntime::unload_page(page);
 }
 
 
@@ -65,44 +55,35 @@ char* _spUtil_readFile(const char* p_path, int* p_length) {
 
 static void *spine_malloc(size_t p_size) {
 
-	if (p_size == 0)
-		return NULL;
-	return memalloc(p_size);
+	return SpineAllocator::alloc(p_size, NULL, 0, "3_6");
 }
 
 static void *spine_realloc(void *ptr, size_t p_size) {
 
-	if (p_size == 0)
-		return NULL;
-	return memrealloc(ptr, p_size);
+	return SpineAllocator::realloc(ptr, p_size, NULL, 0, "3_6");
 }
 
 static void spine_free(void *ptr) {
 
-	if (ptr == NULL)
-		return;
-	memfree(ptr);
+	SpineAllocator::free(ptr);
 }
 
 void _on_animation_state_event(SpineRuntime_3_6* self, int p_track, spEventType p_type, spEvent *p_event, int p_loop_count) {
 
 	switch (p_type) {
 		case SP_ANIMATION_START:
-			self->emit_signal("event", "animation_start", p_track);
+			self->_push_event(SpineEventBuffer::EVENT_START, p_track);
 			break;
 		case SP_ANIMATION_COMPLETE:
-			self->emit_signal("event", "animation_complete", p_track, p_loop_count);
+			self->_push_event(SpineEventBuffer::EVENT_COMPLETE, p_track, NULL, p_loop_count);
+			break;
+		case SP_ANIMATION_EVENT:
+			self->_push_event(SpineEventBuffer::EVENT_EVENT, p_track, p_event->data, p_event->intValue, p_event->floatValue, p_event->stringValue);
 			break;
-		case SP_ANIMATION_EVENT: {
-			Dictionary event;
-			event["name"] = p_event->data->name;
-			event["int"] = p_event->intValue;
-			event["float"] = p_event->floatValue;
-			event["string"] = p_event->stringValue ? p_event->stringValue : "";
-			self->emit_signal("event", "animation_event", p_track, event);
-		} break;
 		case SP_ANIMATION_END:
-			self->emit_signal("event", "animation_end", p_track);
+			self->_push_event(SpineEventBuffer::EVENT_END, p_track);
+			break;
+		default:
 			break;
 	}
 }
@@ -113,16 +94,12 @@ static void spine_animation_callback(spAnimationState *p_state, spEventType p_ty
 
 static Ref<Texture> spine_get_texture(spRegionAttachment *attachment) {
 
-	if (Ref<Texture> *ref = static_cast<Ref<Texture> *>(((spAtlasRegion *)attachment->rendererObject)->page->rendererObject))
-		return *ref;
-	return NULL;
+	return SpineRuntime::get_page_texture(static_cast<SpinePage *>(((spAtlasRegion *)attachment->rendererObject)->page->rendererObject));
 }
 
 static Ref<Texture> spine_get_texture(spMeshAttachment *attachment) {
 
-	if (Ref<Texture> *ref = static_cast<Ref<Texture> *>(((spAtlasRegion *)attachment->rendererObject)->page->rendererObject))
-		return *ref;
-	return NULL;
+	return SpineRuntime::get_page_texture(static_cast<SpinePage *>(((spAtlasRegion *)attachment->rendererObject)->page->rendererObject));
 }
 
 void SpineRuntime_3_6::init() {
@@ -132,52 +109,257 @@ void SpineRuntime_3_6::init() {
 }
 
 
-Ref<SpineResource> SpineRuntime_3_6::load_resource(const String &p_path) {
+// Builds the atlas from a table cooked by cook_atlas(), loading its pages
+// the way spAtlas_create() does.
+static spAtlas *spine_build_atlas(const SpineAtlasTable &p_table, const String &p_dir) {
+    spAtlas *atlas = NEW(spAtlas);
+    Vector<spAtlasPage *> pages;
+    for (int i = 0; i < p_table.pages.size(); i++) {
+        const SpineAtlasTable::Page &source = p_table.pages[i];
+        spAtlasPage *page = spAtlasPage_create(atlas, source.name.utf8().get_data());
+        page->format = (spAtlasFormat)source.format;
+        page->minFilter = (spAtlasFilter)source.min_filter;
+        page->magFilter = (spAtlasFilter)source.mag_filter;
+        page->uWrap = (spAtlasWrap)source.u_wrap;
+        page->vWrap = (spAtlasWrap)source.v_wrap;
+        page->width = source.width;
+        page->height = source.height;
+        if (pages.empty()) {
+            atlas->pages = page;
+        } else {
+            pages[pages.size() - 1]->next = page;
+        }
+        pages.push_back(page);
+        _spAtlasPage_createTexture(page, p_dir.plus_file(source.name).utf8().get_data());
+    }
+    spAtlasRegion *last = NULL;
+    for (int i = 0; i < p_table.regions.size(); i++) {
+        const SpineAtlasTable::Region &source = p_table.regions[i];
+        spAtlasRegion *region = spAtlasRegion_create();
+        region->page = pages[source.page];
+        MALLOC_STR(region->name, source.name.utf8().get_data());
+        region->x = source.x;
+        region->y = source.y;
+        region->width = source.width;
+        region->height = source.height;
+        region->u = source.u;
+        region->v = source.v;
+        region->u2 = source.u2;
+        region->v2 = source.v2;
+        region->offsetX = source.offset_x;
+        region->offsetY = source.offset_y;
+        region->originalWidth = source.original_width;
+        region->originalHeight = source.original_height;
+        region->index = source.index;
+        region->rotate = source.degrees == 90;
+        if (!source.splits.empty()) {
+            region->splits = MALLOC(int, source.splits.size());
+            memcpy(region->splits, source.splits.ptr(), source.splits.size() * sizeof(int));
+        }
+        if (!source.pads.empty()) {
+            region->pads = MALLOC(int, source.pads.size());
+            memcpy(region->pads, source.pads.ptr(), source.pads.size() * sizeof(int));
+        }
+        if (last) {
+            last->next = region;
+        } else {
+            atlas->regions = region;
+        }
+        last = region;
+    }
+    return atlas;
+}
+
+// Pages and regions of the source's atlas as a SpineAtlasTable, so cooked
+// skeletons build their atlas without parsing its text.
+Vector<uint8_t> SpineRuntime_3_6::cook_atlas(const SkeletonSource &p_source) {
+    Vector<uint8_t> atlas_data = SpineRuntime::get_atlas_data(p_source);
+    if (atlas_data.empty()) return Vector<uint8_t>();
+    spine_cooking_atlas = true;
+    spAtlas *atlas = spAtlas_create((const char *)atlas_data.ptr(), atlas_data.size() - 1, "", 0);
+    spine_cooking_atlas = false;
+    if (atlas == NULL) return Vector<uint8_t>();
+    SpineAtlasTable table;
+    HashMap<uint64_t, int> page_ids;
+    for (spAtlasPage *page = atlas->pages; page; page = page->next) {
+        SpineAtlasTable::Page entry;
+        entry.name = String::utf8(page->name);
+        entry.format = page->format;
+        entry.min_filter = page->minFilter;
+        entry.mag_filter = page->magFilter;
+        entry.u_wrap = page->uWrap;
+        entry.v_wrap = page->vWrap;
+        entry.width = page->width;
+        entry.height = page->height;
+        entry.pma = false;
+        page_ids[(uint64_t)page] = table.pages.size();
+        table.pages.push_back(entry);
+    }
+    for (spAtlasRegion *region = atlas->regions; region; region = region->next) {
+        SpineAtlasTable::Region entry;
+        entry.page = page_ids[(uint64_t)region->page];
+        entry.name = String::utf8(region->name);
+        entry.x = region->x;
+        entry.y = region->y;
+        entry.width = region->width;
+        entry.height = region->height;
+        entry.u = region->u;
+        entry.v = region->v;
+        entry.u2 = region->u2;
+        entry.v2 = region->v2;
+        entry.offset_x = region->offsetX;
+        entry.offset_y = region->offsetY;
+        entry.original_width = region->originalWidth;
+        entry.original_height = region->originalHeight;
+        entry.index = region->index;
+        entry.degrees = region->rotate ? 90 : 0;
+        // spAtlas_create() reads four of each
+        for (int i = 0; region->splits && i < 4; i++) {
+            entry.splits.push_back(region->splits[i]);
+        }
+        for (int i = 0; region->pads && i < 4; i++) {
+            entry.pads.push_back(region->pads[i]);
+        }
+        table.regions.push_back(entry);
+    }
+    spAtlas_dispose(atlas);
+    return table.pages.empty() ? Vector<uint8_t>() : table.encode();
+}
+
+// Skeletons using the same atlas file share one spAtlas, see
+// SpineRuntime::share_atlas().
+Ref<SpineResource> SpineRuntime_3_6::load_resource(const SkeletonSource &p_source) {
     Ref<SpineResource> res;
     res.instance();
-    String p_atlas = p_path.get_basename() + ".atlas";
-    spAtlas* atlas = NULL;
     spSkeletonData* data = NULL;
-    atlas = spAtlas_createFromFile(p_atlas.utf8().get_data(), 0);
-    ERR_FAIL_COND_V(atlas == NULL, Ref<SpineResource>());
-    if (p_path.get_extension() == "json"){
+    spAtlas* atlas = (spAtlas*)SpineRuntime::find_atlas("3_6", p_source.get_atlas_key());
+    if (atlas == NULL) {
+        SpineAtlasTable table;
+        if (!p_source.atlas_table.empty() && table.decode(p_source.atlas_table) == OK && !table.pages.empty()) {
+            atlas = spine_build_atlas(table, p_source.atlas_path.get_base_dir());
+        } else {
+            Vector<uint8_t> atlas_data = SpineRuntime::get_atlas_data(p_source);
+            ERR_FAIL_COND_V_MSG(atlas_data.empty(), Ref<SpineResource>(), "Can't open spine atlas: " + p_source.atlas_path);
+            atlas = spAtlas_create((const char *)atlas_data.ptr(), atlas_data.size() - 1, p_source.atlas_path.get_base_dir().utf8().get_data(), 0);
+        }
+        ERR_FAIL_COND_V(atlas == NULL, Ref<SpineResource>());
+        spAtlas *shared = (spAtlas*)SpineRuntime::share_atlas("3_6", p_source.get_atlas_key(), atlas);
+        if (shared != atlas) {
+            spAtlas_dispose(atlas);
+            atlas = shared;
+        }
+    }
+    if (SpineRuntime::is_json(p_source.path)){
         spSkeletonJson *json = spSkeletonJson_create(atlas);
         if (json == NULL) {
-            spAtlas_dispose(atlas);
+            if (SpineRuntime::release_atlas(atlas)) spAtlas_dispose(atlas);
             return Ref<SpineResource>();
         }
         json->scale = 1;
 
-        data = spSkeletonJson_readSkeletonDataFile(json, p_path.utf8().get_data());
+        data = spSkeletonJson_readSkeletonData(json, (const char *)p_source.data.ptr());
         String err_msg = json->error ? json->error : "";
         spSkeletonJson_dispose(json);
         if (data == NULL) {
-            spAtlas_dispose(atlas);
+            if (SpineRuntime::release_atlas(atlas)) spAtlas_dispose(atlas);
 			ERR_FAIL_V_MSG(Ref<SpineResource>(), err_msg);
         }
     } else {
         spSkeletonBinary* bin  = spSkeletonBinary_create(atlas);
         if (bin == NULL) {
-            spAtlas_dispose(atlas);
+            if (SpineRuntime::release_atlas(atlas)) spAtlas_dispose(atlas);
             return Ref<SpineResource>();
         }
         bin->scale = 1;
-        data = spSkeletonBinary_readSkeletonDataFile(bin, p_path.utf8().get_data());
+        data = spSkeletonBinary_readSkeletonData(bin, p_source.data.ptr(), p_source.data.size() - 1);
         String err_msg = bin->error ? bin->error : "";
         spSkeletonBinary_dispose(bin);
         if (data == NULL) {
-            spAtlas_dispose(atlas);
+            if (SpineRuntime::release_atlas(atlas)) spAtlas_dispose(atlas);
             ERR_FAIL_V_MSG(Ref<SpineResource>(), err_msg);
         }
     }
 
     res->atlas = (void*)atlas;
     res->data = (void*)data;
-    res->set_path(p_path);
+    res->state_data = (void*)spAnimationStateData_create(data);
+    res->set_path(p_source.path);
     res->runtime_version = "3_6";
+
+    for (int i = 0; i < data->bonesCount; i++) {
+        String name = String::utf8(data->bones[i]->name);
+        res->bone_ids.set(name, i);
+        res->index_properties(SpineResource::PROPERTY_BONE, name, i);
+    }
+    for (int i = 0; i < data->slotsCount; i++) {
+        String name = String::utf8(data->slots[i]->name);
+        res->slot_ids.set(name, i);
+        res->index_properties(SpineResource::PROPERTY_SLOT, name, i);
+    }
+    for (int i = 0; i < data->pathConstraintsCount; i++) {
+        res->index_properties(SpineResource::PROPERTY_PATH, String::utf8(data->pathConstraints[i]->name), i);
+    }
+    res->animation_names.resize(data->animationsCount);
+    res->animation_durations.resize(data->animationsCount);
+    for (int i = 0; i < data->animationsCount; i++) {
+        StringName name = String::utf8(data->animations[i]->name);
+        res->animation_ids.set(name, i);
+        res->animation_names.write[i] = name;
+        res->animation_durations.write[i] = data->animations[i]->duration;
+    }
+    res->event_names.resize(data->eventsCount);
+    for (int i = 0; i < data->eventsCount; i++) {
+        res->event_names.write[i] = String::utf8(data->events[i]->name);
+        res->event_ids.set((uint64_t)data->events[i], i);
+    }
+    res->skin_names.resize(data->skinsCount);
+    for (int i = 0; i < data->skinsCount; i++) {
+        StringName name = String::utf8(data->skins[i]->name);
+        res->skin_ids.set(name, i);
+        res->skin_names.write[i] = name;
+    }
+    // no origin in 3.6 exports, assume the skeleton stands on it
+    res->bounds = Rect2(-data->width / 2, -data->height, data->width, data->height);
     return res;
 }
 
+spBone *SpineRuntime_3_6::_find_bone(const StringName &p_name) const {
+	int id = resource->find_bone_id(p_name);
+	return id < 0 ? NULL : skeleton->bones[id];
+}
+
+spSlot *SpineRuntime_3_6::_find_slot(const StringName &p_name) const {
+	int id = resource->find_slot_id(p_name);
+	return id < 0 ? NULL : skeleton->slots[id];
+}
+
+spAnimation *SpineRuntime_3_6::_find_animation(const StringName &p_name) const {
+	int id = resource->find_animation_id(p_name);
+	return id < 0 ? NULL : skeleton->data->animations[id];
+}
+
+void SpineRuntime_3_6::set_resource_mix(Ref<SpineResource> p_res, int p_from, int p_to, float p_duration) {
+	ERR_FAIL_COND(p_res.is_null() || !p_res->state_data);
+	spAnimationStateData *state_data = (spAnimationStateData*)p_res->state_data;
+	if (p_from < 0 || p_to < 0) {
+		state_data->defaultMix = p_duration;
+		return;
+	}
+	spSkeletonData *data = (spSkeletonData*)p_res->data;
+	ERR_FAIL_INDEX(p_from, data->animationsCount);
+	ERR_FAIL_INDEX(p_to, data->animationsCount);
+	spAnimationStateData_setMix(state_data, data->animations[p_from], data->animations[p_to], p_duration);
+}
+
+void SpineRuntime_3_6::free_resource(SpineResource *p_res) {
+	if (p_res->state_data) spAnimationStateData_dispose((spAnimationStateData*)p_res->state_data);
+	if (p_res->data) spSkeletonData_dispose((spSkeletonData*)p_res->data);
+	if (p_res->atlas && SpineRuntime::release_atlas(p_res->atlas)) spAtlas_dispose((spAtlas*)p_res->atlas);
+	p_res->state_data = NULL;
+	p_res->data = NULL;
+	p_res->atlas = NULL;
+}
+
 Ref<SpineRuntime> SpineRuntime_3_6::with_resource(Ref<SpineResource> res) {
 	if (res.is_null())
 		return Ref<SpineRuntime>();
@@ -188,101 +370,133 @@ Ref<SpineRuntime> SpineRuntime_3_6::with_resource(Ref<SpineResource> res) {
 
     Ref<SpineRuntime_3_6> rt;
     rt.instance();
-
-	rt->skeleton = spSkeleton_create((spSkeletonData*)res->data);
+    rt->resource = res;
+
+	SpineAllocator::MeasureScope measure;
+	uint64_t skeleton_bytes;
+	{
+		// bones, slots and constraints live exactly as long as the skeleton
+		SpineAllocator::MeasureScope skeleton_measure;
+		SpineAllocator::ArenaScope scope(&rt->skeleton_arena);
+		rt->skeleton = spSkeleton_create((spSkeletonData*)res->data);
+		skeleton_bytes = skeleton_measure.get_bytes();
+	}
 	rt->root_bone = rt->skeleton->bones[0];
 	rt->clipper = spSkeletonClipping_create();
 
-	rt->state = spAnimationState_create(spAnimationStateData_create(rt->skeleton->data));
+	rt->state = spAnimationState_create((spAnimationStateData*)res->state_data);
 	rt->state->rendererObject = rt.ptr();
 	rt->state->listener = spine_animation_callback;
+	rt->_set_instance_bytes(measure.get_bytes(), skeleton_bytes);
     // return memnew(SpineRuntime_3_6);
     return rt;
 }
 
+Dictionary SpineRuntime_3_6::bake_timelines(Ref<SpineResource> p_res, float p_fps, int p_max_bytes, float p_tolerance) {
+	WARN_PRINT("Dense timeline sampling requires spine runtime 4.0 or newer");
+	return Dictionary();
+}
+
+Dictionary SpineRuntime_3_6::compress_timelines(Ref<SpineResource> p_res, float p_translate_tolerance, float p_rotate_tolerance, float p_scale_tolerance) {
+	WARN_PRINT("Keyframe compression requires spine runtime 4.0 or newer");
+	return Dictionary();
+}
+
 void SpineRuntime_3_6::_rt_get_property_list(List<PropertyInfo> *p_list) const {
 	
 }
 
 bool SpineRuntime_3_6::_rt_get(const StringName &p_name, Variant &r_ret) const {
-	String name = p_name;
-	if (name.begins_with("bone/")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size() != 3) return true;
-		spBone *bone = spSkeleton_findBone(skeleton, params[1].utf8().get_data());
-		ERR_FAIL_COND_V(bone==NULL, false);
-		if (params[2] == "rotation")
-			r_ret = bone->rotation;
-		else if (params[2] == "position")
-			r_ret = Vector2(bone->x, bone->y);
-		return true;
-	} else {
-		return false;
+	const SpineResource::Property *property = resource.is_valid() ? resource->find_property(p_name) : NULL;
+	if (property == NULL) return false;
+	if (skeleton == NULL) return true;
+	switch (property->target) {
+		case SpineResource::PROPERTY_BONE: {
+			spBone *bone = skeleton->bones[property->index];
+			if (property->field == SpineResource::FIELD_ROTATION)
+				r_ret = bone->rotation;
+			else
+				r_ret = Vector2(bone->x, bone->y);
+		} break;
+		case SpineResource::PROPERTY_SLOT: {
+			spColor &c = skeleton->slots[property->index]->color;
+			r_ret = Color(c.r, c.g, c.b, c.a);
+		} break;
+		case SpineResource::PROPERTY_PATH: {
+			spPathConstraint *pc = skeleton->pathConstraints[property->index];
+			if (property->field == SpineResource::FIELD_POSITION)
+				r_ret = pc->position;
+			else if (property->field == SpineResource::FIELD_SPACING)
+				r_ret = pc->spacing;
+			else if (property->field == SpineResource::FIELD_TRANSLATE_MIX)
+				r_ret = pc->translateMix;
+			else
+				r_ret = pc->rotateMix;
+		} break;
 	}
+	return true;
 }
 
 bool SpineRuntime_3_6::_rt_set(const StringName &p_name, const Variant &p_value) {
-    String name = p_name;
-	if (name.begins_with("path")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size()!=3) return true;
-		spPathConstraint *pc = spSkeleton_findPathConstraint(skeleton, params[1].utf8().get_data());
-		ERR_FAIL_COND_V(pc==NULL, true);
-		if (params[2] == "position") {
-			pc->position = p_value;
-		} else if (params[2] == "tmix"){
-			pc->translateMix = p_value;
-		} else if (params[2] == "rmix"){
-			pc->rotateMix = p_value;
-		} else if (params[2] == "spacing"){
-			pc->spacing = p_value;
-		}
-		spSkeleton_updateWorldTransform(skeleton);
-        return true;
-	} else if (name.begins_with("bone")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size() != 3) return true;
-		spBone *bone = spSkeleton_findBone(skeleton, params[1].utf8().get_data());
-		ERR_FAIL_COND_V(bone==NULL, true);
-		if (params[2] == "rotation"){
-			bone->rotation = p_value;
-		}
-		else if (params[2] == "position"){
-			Vector2 v(p_value);
-			bone->x = v.x;
-			bone->y = v.y;
-		}
-		spSkeleton_updateWorldTransform(skeleton);
-        return true;
-	} else if (name.begins_with("slot")){
-		if (skeleton == NULL) return true;
-		Vector<String> params = name.split("/");
-		if (params.size() != 3) return true;
-		spSlot *slot = spSkeleton_findSlot(skeleton, params[1].utf8().get_data());
-		ERR_FAIL_COND_V(slot==NULL, true);
-		if (params[2] == "color"){
+	const SpineResource::Property *property = resource.is_valid() ? resource->find_property(p_name) : NULL;
+	if (property == NULL) return false;
+	if (skeleton == NULL) return true;
+	switch (property->target) {
+		case SpineResource::PROPERTY_BONE: {
+			spBone *bone = skeleton->bones[property->index];
+			if (property->field == SpineResource::FIELD_ROTATION) {
+				bone->rotation = p_value;
+			} else {
+				Vector2 v(p_value);
+				bone->x = v.x;
+				bone->y = v.y;
+			}
+			manual_pose = true;
+			bones_dirty = true;
+		} break;
+		case SpineResource::PROPERTY_SLOT: {
 			Color c = p_value;
+			spSlot *slot = skeleton->slots[property->index];
 			slot->color.a = skeleton->color.a * c.a;
 			slot->color.r = skeleton->color.r * c.r;
-			slot->color.g = skeleton->color.r * c.g;
+			slot->color.g = skeleton->color.g * c.g;
 			slot->color.b = skeleton->color.b * c.b;
-		}
-        return true;
-	} else {
-        return false;
-    }
+		} break;
+		case SpineResource::PROPERTY_PATH: {
+			spPathConstraint *pc = skeleton->pathConstraints[property->index];
+			if (property->field == SpineResource::FIELD_POSITION) {
+				pc->position = p_value;
+			} else if (property->field == SpineResource::FIELD_TRANSLATE_MIX) {
+				pc->translateMix = p_value;
+			} else if (property->field == SpineResource::FIELD_ROTATE_MIX) {
+				pc->rotateMix = p_value;
+			} else {
+				pc->spacing = p_value;
+			}
+			manual_pose = true;
+			bones_dirty = true;
+		} break;
+	}
+	return true;
+}
+
+// spine-c has no per-bone update entry point, so property writes only
+// defer the world transform update to the next draw or pose query.
+void SpineRuntime_3_6::_update_dirty_bones() const {
+	if (!bones_dirty) return;
+	bones_dirty = false;
+	spSkeleton_updateWorldTransform(skeleton);
 }
 
 void SpineRuntime_3_6::batch(SpineBatcher* batcher, const Color &modulate, bool flip_x, bool flip_y, bool individual_textures) {
+    _update_dirty_bones();
     spColor_setFromFloats(&skeleton->color, modulate.r, modulate.g, modulate.b, modulate.a);
 
 	int additive = 0;
 	Color color;
 	float *uvs = NULL;
 	int verties_count = 0;
+	float *world_verts = NULL;
 	unsigned short *triangles = NULL;
 	int triangles_count = 0;
 	float r = 0, g = 0, b = 0, a = 0;
@@ -307,7 +521,8 @@ void SpineRuntime_3_6::batch(SpineBatcher* batcher, const Color &modulate, bool
 					spSkeletonClipping_clipEnd(clipper, slot);
 					continue;
 				}
-				spRegionAttachment_computeWorldVertices(attachment, slot->bone, world_verts.ptrw(), 0, 2);
+				world_verts = get_scratch_vertices(8);
+				spRegionAttachment_computeWorldVertices(attachment, slot->bone, world_verts, 0, 2);
 				texture = spine_get_texture(attachment);
 				uvs = attachment->uvs;
 				verties_count = 8;
@@ -327,7 +542,8 @@ void SpineRuntime_3_6::batch(SpineBatcher* batcher, const Color &modulate, bool
 					spSkeletonClipping_clipEnd(clipper, slot);
 					continue;
 				}
-				spVertexAttachment_computeWorldVertices(SUPER(attachment), slot, 0, attachment->super.worldVerticesLength, world_verts.ptrw(), 0, 2);
+				world_verts = get_scratch_vertices(attachment->super.worldVerticesLength);
+				spVertexAttachment_computeWorldVertices(SUPER(attachment), slot, 0, attachment->super.worldVerticesLength, world_verts, 0, 2);
 				texture = spine_get_texture(attachment);
 				uvs = attachment->uvs;
 				verties_count = ((spVertexAttachment *)attachment)->worldVerticesLength;
@@ -363,7 +579,7 @@ void SpineRuntime_3_6::batch(SpineBatcher* batcher, const Color &modulate, bool
 		color.b = skeleton->color.b * slot->color.b * b;
 
 		if (spSkeletonClipping_isClipping(clipper)){
-			spSkeletonClipping_clipTriangles(clipper, world_verts.ptrw(), verties_count, triangles, triangles_count, uvs, 2);
+			spSkeletonClipping_clipTriangles(clipper, world_verts, verties_count, triangles, triangles_count, uvs, 2);
 			if (clipper->clippedTriangles->size == 0){
 				spSkeletonClipping_clipEnd(clipper, slot);
 				continue;
@@ -375,7 +591,7 @@ void SpineRuntime_3_6::batch(SpineBatcher* batcher, const Color &modulate, bool
 								 clipper->clippedTriangles->size,
 								 &color, flip_x, flip_y, (slot->data->index)*individual_textures);
 		} else {
-			batcher->add(texture, world_verts.ptr(), uvs, verties_count, triangles, triangles_count, &color, flip_x, flip_y, (slot->data->index)*individual_textures);
+			batcher->add(texture, world_verts, uvs, verties_count, triangles, triangles_count, &color, flip_x, flip_y, (slot->data->index)*individual_textures);
 		}
 		spSkeletonClipping_clipEnd(clipper, slot);
 	}
@@ -386,10 +602,72 @@ void SpineRuntime_3_6::batch(SpineBatcher* batcher, const Color &modulate, bool
 	batcher->flush();
 }
 
+// Serves bone world transforms from the resource pose cache for plain
+// single-track playback. Returns false when the caller has to run
+// spSkeleton_updateWorldTransform itself; on a miss the computed pose is stored.
+bool SpineRuntime_3_6::_apply_cached_pose() {
+	SpinePoseCache &cache = resource->pose_cache;
+	if (!cache.is_enabled() || manual_pose) return false;
+
+	spTrackEntry *entry = NULL;
+	for (int i = 0; i < state->tracksCount; i++) {
+		if (state->tracks[i] == NULL) continue;
+		if (entry != NULL) return false;
+		entry = state->tracks[i];
+	}
+	if (entry == NULL || entry->animation == NULL) return false;
+	if (entry->mixingFrom != NULL || entry->alpha < 1 || entry->trackTime < 0) return false;
+
+	float time = entry->trackTime;
+	if (entry->loop && entry->animationEnd > entry->animationStart) {
+		time = entry->animationStart + Math::fmod(time, entry->animationEnd - entry->animationStart);
+	} else {
+		time = MIN(entry->animationStart + time, entry->animationEnd);
+	}
+
+	SpinePoseCache::Key key;
+	key.skin = skeleton->skin;
+	key.animation = entry->animation;
+	key.frame = cache.quantize(time);
+
+	const float *pose = cache.get(key);
+	if (pose != NULL) {
+		for (int i = 0; i < skeleton->bonesCount; i++, pose += SpinePoseCache::FLOATS_PER_BONE) {
+			spBone *bone = skeleton->bones[i];
+			CONST_CAST(float, bone->a) = pose[0];
+			CONST_CAST(float, bone->b) = pose[1];
+			CONST_CAST(float, bone->c) = pose[2];
+			CONST_CAST(float, bone->d) = pose[3];
+			CONST_CAST(float, bone->worldX) = pose[4];
+			CONST_CAST(float, bone->worldY) = pose[5];
+		}
+		return true;
+	}
+
+	spSkeleton_updateWorldTransform(skeleton);
+	Vector<float> computed;
+	computed.resize(skeleton->bonesCount * SpinePoseCache::FLOATS_PER_BONE);
+	float *w = computed.ptrw();
+	for (int i = 0; i < skeleton->bonesCount; i++, w += SpinePoseCache::FLOATS_PER_BONE) {
+		spBone *bone = skeleton->bones[i];
+		w[0] = bone->a;
+		w[1] = bone->b;
+		w[2] = bone->c;
+		w[3] = bone->d;
+		w[4] = bone->worldX;
+		w[5] = bone->worldY;
+	}
+	cache.store(key, computed.ptr(), computed.size());
+	return true;
+}
+
 void SpineRuntime_3_6::process(float delta) {
     spAnimationState_update(state, delta);
 	spAnimationState_apply(state, skeleton);
-	spSkeleton_updateWorldTransform(skeleton);
+	bones_dirty = false;
+	if (!_apply_cached_pose()) {
+		spSkeleton_updateWorldTransform(skeleton);
+	}
 
 	// Calculate and draw mesh only if timelines has been changed
 	// String current_state_hash = build_state_hash();
@@ -400,33 +678,32 @@ void SpineRuntime_3_6::process(float delta) {
 	// }
 
 
-	for (AttachmentNodes::Element *E = attachment_nodes.front(); E; E = E->next()) {
-
+	// followers queued for deletion are detached when they leave the tree,
+	// the others wait outside it until they are added back or turn out to
+	// have been freed
+	for (AttachmentNodes::Element *E = attachment_nodes.front(), *N = NULL; E; E = N) {
+		N = E->next();
 		AttachmentNode &info = E->get();
-		WeakRef *ref = info.ref;
-		Object *obj = ref->get_ref();
-		Node2D *node = (obj != NULL) ? Object::cast_to<Node2D>(obj) : NULL;
-		if (obj == NULL || node == NULL) {
-
-			AttachmentNodes::Element *NEXT = E->next();
-			attachment_nodes.erase(E);
-			E = NEXT;
-			if (E == NULL)
-				break;
+		if (!info.inside) {
+			if (ObjectDB::get_instance(info.node_id) == NULL) {
+				_detach_node(&info);
+			}
 			continue;
 		}
-        spSlot *slot = info.slot;
-		spBone *bone = slot->bone;
-		node->call("set_position", Vector2(bone->worldX + bone->skeleton->x, -bone->worldY + bone->skeleton->y) + info.ofs);
-		node->call("set_scale", Vector2(spBone_getWorldScaleX(bone), spBone_getWorldScaleY(bone)) * info.scale);
-		//node->call("set_rotation", Math::atan2(bone->c, bone->d) + Math::deg2rad(info.rot));
-		node->call("set_rotation_degrees", spBone_getWorldRotationX(bone) + info.rot);
-        Color c;
-        c.a = slot->color.a;
-        c.r = slot->color.r;
-        c.g = slot->color.g;
-        c.b = slot->color.b;
-        node->call("set_modulate", c);
+		spBone *bone = info.bone;
+		Transform2D xform;
+		xform.set_rotation_and_scale(Math::deg2rad(spBone_getWorldRotationX(bone) + info.rot), Vector2(spBone_getWorldScaleX(bone), spBone_getWorldScaleY(bone)) * info.scale);
+		xform.elements[2] = Vector2(bone->worldX + skeleton->x, -bone->worldY + skeleton->y) + info.ofs;
+		Color color(info.slot->color.r, info.slot->color.g, info.slot->color.b, info.slot->color.a);
+		if (!info.synced || xform != info.xform) {
+			info.node->set_transform(xform);
+			info.xform = xform;
+		}
+		if (!info.synced || color != info.color) {
+			info.node->set_modulate(color);
+			info.color = color;
+		}
+		info.synced = true;
 	}
 }
 
@@ -464,7 +741,7 @@ Array SpineRuntime_3_6::get_skin_names() const {
 
 bool SpineRuntime_3_6::has_animation(const String &p_name) {
 	if (skeleton == NULL) return false;
-	spAnimation *animation = spSkeletonData_findAnimation(skeleton->data, p_name.utf8().get_data());
+	spAnimation *animation = _find_animation(p_name);
 	return animation != NULL;
 }
 
@@ -473,18 +750,48 @@ bool SpineRuntime_3_6::set_skin(const String &p_name) {
 	return spSkeleton_setSkinByName(skeleton, p_name.utf8().get_data()) ? true : false;
 }
 
+bool SpineRuntime_3_6::set_skins(const Vector<int> &p_skin_ids, bool p_bake) {
+	WARN_PRINT("Composing skins requires spine runtime 3.8 or newer");
+	return false;
+}
+
 
 
 void SpineRuntime_3_6::mix(const String &p_from, const String &p_to, real_t p_duration) {
 	ERR_FAIL_COND(state == NULL);
-	spAnimationStateData_setMixByName(state->data, p_from.utf8().get_data(), p_to.utf8().get_data(), p_duration);
+	spAnimation *from = _find_animation(p_from);
+	spAnimation *to = _find_animation(p_to);
+	ERR_FAIL_COND(from == NULL || to == NULL);
+	_set_mix_override(from, to, p_duration);
+}
+
+spTrackEntry *SpineRuntime_3_6::_set_animation(int p_track, spAnimation *p_animation, bool p_loop) {
+	spTrackEntry *entry = spAnimationState_setAnimation(state, p_track, p_animation, p_loop);
+	if (entry == NULL || mix_overrides.empty() || entry->mixingFrom == NULL) return entry;
+	const float *duration = _get_mix_override(entry->mixingFrom->animation, p_animation);
+	if (duration) entry->mixDuration = *duration;
+	return entry;
+}
+
+spTrackEntry *SpineRuntime_3_6::_add_animation(int p_track, spAnimation *p_animation, bool p_loop, float p_delay) {
+	spTrackEntry *last = mix_overrides.empty() ? NULL : spAnimationState_getCurrent(state, p_track);
+	while (last && last->next) last = last->next;
+	spTrackEntry *entry = spAnimationState_addAnimation(state, p_track, p_animation, p_loop, p_delay);
+	if (entry == NULL || last == NULL) return entry;
+	const float *duration = _get_mix_override(last->animation, p_animation);
+	if (duration) {
+		// a non-positive delay was resolved against the shared mix duration
+		if (p_delay <= 0) entry->delay = MAX(0.0f, entry->delay + entry->mixDuration - *duration);
+		entry->mixDuration = *duration;
+	}
+	return entry;
 }
 
 bool SpineRuntime_3_6::play(const String &p_name, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
 	ERR_FAIL_COND_V(skeleton == NULL, false);
-	spAnimation *animation = spSkeletonData_findAnimation(skeleton->data, p_name.utf8().get_data());
+	spAnimation *animation = _find_animation(p_name);
 	ERR_FAIL_COND_V(animation == NULL, false);
-	spTrackEntry *entry = spAnimationState_setAnimation(state, p_track, animation, p_loop);
+	spTrackEntry *entry = _set_animation(p_track, animation, p_loop);
 	entry->delay = p_delay;
 	entry->timeScale = p_cunstom_scale;
 	return true;
@@ -492,18 +799,18 @@ bool SpineRuntime_3_6::play(const String &p_name, real_t p_cunstom_scale, bool p
 
 void SpineRuntime_3_6::set_animation_state(int p_track, String p_animation, float p_pos) {
 	ERR_FAIL_COND(skeleton == NULL);
-	spAnimation *animation = spSkeletonData_findAnimation(skeleton->data, p_animation.utf8().get_data());
+	spAnimation *animation = _find_animation(p_animation);
 	ERR_FAIL_COND(animation == NULL);
-	spTrackEntry *entry = spAnimationState_setAnimation(state, p_track, animation, false);
+	spTrackEntry *entry = _set_animation(p_track, animation, false);
 	if (entry == NULL) return;
 	entry->trackTime = p_pos;
 }
 
 bool SpineRuntime_3_6::add(const String &p_name, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
 	ERR_FAIL_COND_V(skeleton == NULL, false);
-	spAnimation *animation = spSkeletonData_findAnimation(skeleton->data, p_name.utf8().get_data());
+	spAnimation *animation = _find_animation(p_name);
 	ERR_FAIL_COND_V(animation == NULL, false);
-	spTrackEntry *entry = spAnimationState_addAnimation(state, p_track, animation, p_loop, p_delay);
+	spTrackEntry *entry = _add_animation(p_track, animation, p_loop, p_delay);
 	return true;
 }
 
@@ -533,12 +840,26 @@ void SpineRuntime_3_6::reset() {
 	if (skeleton == NULL) {
 		return;
 	}
+	manual_pose = false;
+	bones_dirty = false;
 	spSkeleton_setToSetupPose(skeleton);
 	spAnimationState_update(state, 0);
 	spAnimationState_apply(state, skeleton);
 	spSkeleton_updateWorldTransform(skeleton);
 }
 
+// Returns the runtime to the state with_resource() left it in.
+void SpineRuntime_3_6::recycle() {
+	if (skeleton == NULL) return;
+	while (attachment_nodes.front()) {
+		_detach_node(&attachment_nodes.front()->get());
+	}
+	mix_overrides.clear();
+	spAnimationState_clearTracks(state);
+	spSkeleton_setSkin(skeleton, NULL);
+	reset();
+}
+
 void SpineRuntime_3_6::seek(int track, float p_pos) {
 	if (state == NULL) return;
 	spTrackEntry *entry = spAnimationState_getCurrent(state, track);
@@ -556,6 +877,7 @@ float SpineRuntime_3_6::tell(int track) const {
 Dictionary SpineRuntime_3_6::get_skeleton(bool individual_textures) const {
 
 	ERR_FAIL_COND_V(skeleton == NULL, Variant());
+	_update_dirty_bones();
 	Dictionary dict;
 
 	dict["bonesCount"] = skeleton->bonesCount;
@@ -672,7 +994,8 @@ Dictionary SpineRuntime_3_6::get_attachment(const String &p_slot_name, const Str
 Dictionary SpineRuntime_3_6::get_bone(const String &p_bone_name) const {
 
 	ERR_FAIL_COND_V(skeleton == NULL, Variant());
-	spBone *bone = spSkeleton_findBone(skeleton, p_bone_name.utf8().get_data());
+	_update_dirty_bones();
+	spBone *bone = _find_bone(p_bone_name);
 	ERR_FAIL_COND_V(bone == NULL, Variant());
 	Dictionary dict;
 	dict["x"] = bone->x;
@@ -700,7 +1023,7 @@ Dictionary SpineRuntime_3_6::get_bone(const String &p_bone_name) const {
 
 Dictionary SpineRuntime_3_6::get_slot(const String &p_slot_name) const {
 	ERR_FAIL_COND_V(skeleton == NULL, Variant());
-	spSlot *slot = spSkeleton_findSlot(skeleton, p_slot_name.utf8().get_data());
+	spSlot *slot = _find_slot(p_slot_name);
 	ERR_FAIL_COND_V(slot == NULL, Variant());
 	Dictionary dict;
 	dict["color"] = Color(slot->color.r, slot->color.g, slot->color.b, slot->color.a);
@@ -728,12 +1051,13 @@ bool SpineRuntime_3_6::has_attachment_node(const String &p_bone_name, const Vari
 bool SpineRuntime_3_6::add_attachment_node(const String &p_bone_name, const Variant &p_node, const Vector2 &p_ofs, const Vector2 &p_scale, const real_t p_rot) {
 
 	ERR_FAIL_COND_V(skeleton == NULL, false);
-	spSlot *slot = spSkeleton_findSlot(skeleton, p_bone_name.utf8().get_data());
+	spSlot *slot = _find_slot(p_bone_name);
 	ERR_FAIL_COND_V(slot == NULL, false);
 	Object *obj = p_node;
 	ERR_FAIL_COND_V(obj == NULL, false);
 	Node2D *node = Object::cast_to<Node2D>(obj);
 	ERR_FAIL_COND_V(node == NULL, false);
+	ERR_FAIL_COND_V_MSG(!node->is_inside_tree(), false, "Attachment node must be inside the scene tree");
 
 	if (obj->has_meta("spine_meta")) {
 
@@ -753,12 +1077,17 @@ bool SpineRuntime_3_6::add_attachment_node(const String &p_bone_name, const Vari
 	AttachmentNode &info = attachment_nodes.back()->get();
 	info.E = attachment_nodes.back();
 	info.slot = slot;
-	info.ref = memnew(WeakRef);
-	info.ref->set_obj(node);
+	info.bone = slot->bone;
+	info.node = node;
 	info.ofs = p_ofs;
 	info.scale = p_scale;
 	info.rot = p_rot;
+	info.node_id = node->get_instance_id();
+	info.synced = false;
+	info.inside = true;
 	obj->set_meta("spine_meta", (uint64_t)&info);
+	node->connect("tree_exiting", this, "_on_attachment_node_exiting", varray(node));
+	node->connect("tree_entered", this, "_on_attachment_node_entered", varray(node));
 
 	return true;
 }
@@ -766,7 +1095,7 @@ bool SpineRuntime_3_6::add_attachment_node(const String &p_bone_name, const Vari
 bool SpineRuntime_3_6::remove_attachment_node(const String &p_bone_name, const Variant &p_node) {
 
 	ERR_FAIL_COND_V(skeleton == NULL, false);
-	spSlot *slot = spSkeleton_findSlot(skeleton, p_bone_name.utf8().get_data());
+	spSlot *slot = _find_slot(p_bone_name);
 	ERR_FAIL_COND_V(slot == NULL, false);
 	Object *obj = p_node;
 	ERR_FAIL_COND_V(obj == NULL, false);
@@ -778,13 +1107,42 @@ bool SpineRuntime_3_6::remove_attachment_node(const String &p_bone_name, const V
 
 	AttachmentNode *info = (AttachmentNode *)((uint64_t)obj->get_meta("spine_meta"));
 	ERR_FAIL_COND_V(info->slot != slot, false);
-	obj->set_meta("spine_meta", Variant());
-	memdelete(info->ref);
-	attachment_nodes.erase(info->E);
+	_detach_node(info);
 
 	return false;
 }
 
+void SpineRuntime_3_6::_detach_node(AttachmentNode *p_info) {
+	Node2D *node = p_info->node;
+	// a follower freed with free() while out of the tree is gone already
+	if (ObjectDB::get_instance(p_info->node_id) == node) {
+		node->set_meta("spine_meta", Variant());
+		node->disconnect("tree_exiting", this, "_on_attachment_node_exiting");
+		node->disconnect("tree_entered", this, "_on_attachment_node_entered");
+	}
+	attachment_nodes.erase(p_info->E);
+}
+
+// Reparenting the follower, or the Spine node it is a child of, keeps it
+// attached; a follower queued for deletion is detached right away, one
+// freed with free() by the next process(), as it is still alive here.
+void SpineRuntime_3_6::_on_attachment_node_exiting(Object *p_node) {
+	if (!p_node->has_meta("spine_meta")) return;
+	AttachmentNode *info = (AttachmentNode *)((uint64_t)p_node->get_meta("spine_meta"));
+	if (p_node->is_queued_for_deletion()) {
+		_detach_node(info);
+	} else {
+		info->inside = false;
+	}
+}
+
+void SpineRuntime_3_6::_on_attachment_node_entered(Object *p_node) {
+	if (!p_node->has_meta("spine_meta")) return;
+	AttachmentNode *info = (AttachmentNode *)((uint64_t)p_node->get_meta("spine_meta"));
+	info->inside = true;
+	info->synced = false;
+}
+
 Ref<Shape2D> SpineRuntime_3_6::get_bounding_box(const String& p_slot_name, const String& p_attachment_name) {
     ERR_FAIL_COND_V(skeleton == NULL, Ref<Shape2D>());
 	spAttachment *attachment = spSkeleton_getAttachmentForSlotName(skeleton, p_slot_name.utf8().get_data(), p_attachment_name.utf8().get_data());
@@ -819,28 +1177,85 @@ bool SpineRuntime_3_6::add_bounding_box(const String &p_bone_name, const String
 }
 
 Vector2 SpineRuntime_3_6::get_bone_position(const String &bone_name) {
-    spBone *bone = spSkeleton_findBone(skeleton, bone_name.utf8().get_data());
+    spBone *bone = _find_bone(bone_name);
     if (bone == NULL) return Vector2();
     return Vector2(bone->x, bone->y);
 }
 float SpineRuntime_3_6::get_bone_rotation(const String &bone_name) {
-    spBone *bone = spSkeleton_findBone(skeleton, bone_name.utf8().get_data());
+    spBone *bone = _find_bone(bone_name);
     if (bone == NULL) return 0.0;
     return bone->rotation;
 }
 
 
 
+// Overrides local position and rotation of many bones at once, followed by
+// a single world transform pass. Either array may be empty to leave that
+// channel untouched.
+bool SpineRuntime_3_6::set_bones_local(const PoolIntArray &p_bone_ids, const PoolVector2Array &p_positions, const PoolRealArray &p_rotations) {
+	if (skeleton == NULL) return false;
+	int count = p_bone_ids.size();
+	ERR_FAIL_COND_V(p_positions.size() != 0 && p_positions.size() != count, false);
+	ERR_FAIL_COND_V(p_rotations.size() != 0 && p_rotations.size() != count, false);
+
+	PoolIntArray::Read ids = p_bone_ids.read();
+	PoolVector2Array::Read positions = p_positions.read();
+	PoolRealArray::Read rotations = p_rotations.read();
+	for (int i = 0; i < count; i++) {
+		ERR_CONTINUE(ids[i] < 0 || ids[i] >= skeleton->bonesCount);
+		spBone *bone = skeleton->bones[ids[i]];
+		if (p_positions.size()) {
+			bone->x = positions[i].x;
+			bone->y = positions[i].y;
+		}
+		if (p_rotations.size()) {
+			bone->rotation = rotations[i];
+		}
+	}
+	manual_pose = true;
+	bones_dirty = true;
+	_update_dirty_bones();
+	return true;
+}
+
+bool SpineRuntime_3_6::play_id(int p_animation_id, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
+	ERR_FAIL_COND_V(skeleton == NULL, false);
+	ERR_FAIL_INDEX_V(p_animation_id, skeleton->data->animationsCount, false);
+	spTrackEntry *entry = _set_animation(p_track, skeleton->data->animations[p_animation_id], p_loop);
+	entry->delay = p_delay;
+	entry->timeScale = p_cunstom_scale;
+	return true;
+}
+
+bool SpineRuntime_3_6::add_id(int p_animation_id, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
+	ERR_FAIL_COND_V(skeleton == NULL, false);
+	ERR_FAIL_INDEX_V(p_animation_id, skeleton->data->animationsCount, false);
+	spTrackEntry *entry = _add_animation(p_track, skeleton->data->animations[p_animation_id], p_loop, p_delay);
+	entry->timeScale = p_cunstom_scale;
+	return true;
+}
+
+// Bone world transform in node space (y axis pointing down).
+Transform2D SpineRuntime_3_6::get_bone_world_by_id(int p_bone_id) const {
+	ERR_FAIL_COND_V(skeleton == NULL, Transform2D());
+	ERR_FAIL_INDEX_V(p_bone_id, skeleton->bonesCount, Transform2D());
+	_update_dirty_bones();
+	spBone *bone = skeleton->bones[p_bone_id];
+	return Transform2D(bone->a, -bone->c, -bone->b, bone->d, bone->worldX, -bone->worldY);
+}
+
 SpineRuntime_3_6::SpineRuntime_3_6() {
-    world_verts.resize(1000); // Max number of vertices per mesh.
-	memset(world_verts.ptrw(), 0, world_verts.size() * sizeof(float));
+    skeleton = NULL;
+    root_bone = NULL;
+    state = NULL;
+    clipper = NULL;
+    manual_pose = false;
+    bones_dirty = false;
 }
 
 SpineRuntime_3_6::~SpineRuntime_3_6() {
-    if (state) {
-		spAnimationStateData_dispose(state->data);
+    if (state)
 		spAnimationState_dispose(state);
-	}
 
 	if (skeleton)
 		spSkeleton_dispose(skeleton);
@@ -852,10 +1267,8 @@ SpineRuntime_3_6::~SpineRuntime_3_6() {
 	skeleton = NULL;
 	clipper = NULL;
     
-    for (AttachmentNodes::Element *E = attachment_nodes.front(); E; E = E->next()) {
-		AttachmentNode &node = E->get();
-		memdelete(node.ref);
+    while (attachment_nodes.front()) {
+		_detach_node(&attachment_nodes.front()->get());
 	}
-	attachment_nodes.clear();
 }
 
@@ -10,18 +10,37 @@ class SpineRuntime_3_6: public SpineRuntime {
 	spBone* root_bone;
 	spAnimationState* state;
 	spSkeletonClipping *clipper;
-    mutable Vector<float> world_verts;
+    bool manual_pose;
+    mutable bool bones_dirty;
+
+    bool _apply_cached_pose();
+    void _update_dirty_bones() const;
+    spBone *_find_bone(const StringName &p_name) const;
+    spSlot *_find_slot(const StringName &p_name) const;
+    spAnimation *_find_animation(const StringName &p_name) const;
+    spTrackEntry *_set_animation(int p_track, spAnimation *p_animation, bool p_loop);
+    spTrackEntry *_add_animation(int p_track, spAnimation *p_animation, bool p_loop, float p_delay);
 
     typedef struct AttachmentNode {
 		List<AttachmentNode>::Element *E;
 		spSlot *slot;
-		WeakRef *ref;
+		spBone *bone;
+		Node2D *node;
+		ObjectID node_id;
 		Vector2 ofs;
 		Vector2 scale;
 		real_t rot;
+		// last values written to the node
+		Transform2D xform;
+		Color color;
+		bool synced;
+		// false while the node is out of the tree
+		bool inside;
 	} AttachmentNode;
 	typedef List<AttachmentNode> AttachmentNodes;
 	AttachmentNodes attachment_nodes;
+
+    void _detach_node(AttachmentNode *p_info);
 #endif
 
 public:
@@ -31,8 +50,13 @@ public:
 
 
     static void init();
-    static Ref<SpineResource> load_resource(const String &path);
+    static Ref<SpineResource> load_resource(const SkeletonSource &source);
+    static Vector<uint8_t> cook_atlas(const SkeletonSource &p_source);
     static Ref<SpineRuntime> with_resource(Ref<SpineResource>);
+    static Dictionary bake_timelines(Ref<SpineResource> p_res, float p_fps, int p_max_bytes, float p_tolerance);
+    static Dictionary compress_timelines(Ref<SpineResource> p_res, float p_translate_tolerance, float p_rotate_tolerance, float p_scale_tolerance);
+    static void set_resource_mix(Ref<SpineResource> p_res, int p_from, int p_to, float p_duration);
+    static void free_resource(SpineResource *p_res);
 
     virtual void batch(SpineBatcher* batcher, const Color &modulate, bool flip_x, bool flip_y, bool individual_textures);
     virtual void process(float delta);
@@ -42,6 +66,7 @@ public:
     virtual Array get_skin_names() const;
     virtual bool has_animation(const String& p_name);
     virtual bool set_skin(const String& p_name);
+    virtual bool set_skins(const Vector<int> &p_skin_ids, bool p_bake);
 
     virtual void mix(const String& p_from, const String& p_to, real_t p_duration);
     virtual bool play(const String& p_name, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
@@ -51,6 +76,7 @@ public:
     virtual bool is_playing(int p_track = 0) const;
     virtual String get_current_animation(int p_track = 0) const;
     virtual void reset();
+    virtual void recycle();
     virtual void seek(int track, float p_pos);
     virtual float tell(int track) const;
 
@@ -63,12 +89,19 @@ public:
     virtual bool has_attachment_node(const String& p_bone_name, const Variant& p_node);
 	virtual bool add_attachment_node(const String& p_bone_name, const Variant& p_node, const Vector2& p_ofs = Vector2(0, 0), const Vector2& p_scale = Vector2(1, 1), const real_t p_rot = 0);
 	virtual bool remove_attachment_node(const String& p_bone_name, const Variant& p_node);
+	virtual void _on_attachment_node_exiting(Object *p_node);
+	virtual void _on_attachment_node_entered(Object *p_node);
     
     virtual Ref<Shape2D> get_bounding_box(const String& p_slot_name, const String& p_attachment_name);
     virtual bool add_bounding_box(const String& p_bone_name, const String& p_slot_name, const String& p_attachment_name, const Variant& p_node, const Vector2& p_ofs = Vector2(0, 0), const Vector2& p_scale = Vector2(1, 1), const real_t p_rot = 0);
 
     virtual Vector2 get_bone_position(const String &bone_name);
     virtual float get_bone_rotation(const String &bone_name);
+    virtual bool set_bones_local(const PoolIntArray &p_bone_ids, const PoolVector2Array &p_positions, const PoolRealArray &p_rotations);
+
+    virtual bool play_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
+    virtual bool add_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
+    virtual Transform2D get_bone_world_by_id(int p_bone_id) const;
 
     SpineRuntime_3_6();
     ~SpineRuntime_3_6();
@@ -9,19 +9,45 @@ class SpineRuntime_4_0: public SpineRuntime {
     typedef struct AttachmentNode {
 		List<AttachmentNode>::Element *E;
 		sp::Slot *slot;
-		WeakRef *ref;
+		sp::Bone *bone;
+		Node2D *node;
+		ObjectID node_id;
 		Vector2 ofs;
 		Vector2 scale;
 		real_t rot;
+		// last values written to the node
+		Transform2D xform;
+		Color color;
+		bool synced;
+		// false while the node is out of the tree
+		bool inside;
 	} AttachmentNode;
 	typedef List<AttachmentNode> AttachmentNodes;
 	AttachmentNodes attachment_nodes;
 
+    void _detach_node(AttachmentNode *p_info);
+    void _release_worn_skin();
+
     sp::Skeleton* skeleton;
     sp::Bone* root_bone;
 	sp::AnimationState* state;
 	sp::SkeletonClipping *clipper;
-    sp::Vector<float> world_verts;
+	// composed skin set_skins() holds for this runtime
+	void *worn_skin;
+    bool manual_pose;
+    mutable bool bones_dirty;
+    mutable Vector<uint8_t> dirty_bones;
+    mutable Vector<uint8_t> affected_bones;
+
+    bool _apply_cached_pose();
+    void _mark_bone_dirty(sp::Bone *p_bone);
+    void _clear_dirty_bones();
+    void _update_dirty_bones() const;
+    sp::Bone *_find_bone(const StringName &p_name) const;
+    sp::Slot *_find_slot(const StringName &p_name) const;
+    sp::Animation *_find_animation(const StringName &p_name) const;
+    sp::TrackEntry *_set_animation(int p_track, sp::Animation *p_animation, bool p_loop);
+    sp::TrackEntry *_add_animation(int p_track, sp::Animation *p_animation, bool p_loop, float p_delay);
 #endif
 
 public:
@@ -30,8 +56,13 @@ public:
 	virtual void _rt_get_property_list(List<PropertyInfo> *p_list) const;
 
     static void init();
-    static Ref<SpineResource> load_resource(const String &path);
+    static Ref<SpineResource> load_resource(const SkeletonSource &source);
+    static Vector<uint8_t> cook_atlas(const SkeletonSource &p_source);
     static Ref<SpineRuntime> with_resource(Ref<SpineResource>);
+    static Dictionary bake_timelines(Ref<SpineResource> p_res, float p_fps, int p_max_bytes, float p_tolerance);
+    static Dictionary compress_timelines(Ref<SpineResource> p_res, float p_translate_tolerance, float p_rotate_tolerance, float p_scale_tolerance);
+    static void set_resource_mix(Ref<SpineResource> p_res, int p_from, int p_to, float p_duration);
+    static void free_resource(SpineResource *p_res);
 
     virtual void batch(SpineBatcher* batcher, const Color &modulate, bool flip_x, bool flip_y, bool individual_textures);
     virtual void process(float delta);
@@ -41,6 +72,7 @@ public:
     virtual Array get_skin_names() const;
     virtual bool has_animation(const String& p_name);
     virtual bool set_skin(const String& p_name);
+    virtual bool set_skins(const Vector<int> &p_skin_ids, bool p_bake);
 
     virtual void mix(const String& p_from, const String& p_to, real_t p_duration);
     virtual bool play(const String& p_name, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
@@ -50,6 +82,7 @@ public:
     virtual bool is_playing(int p_track = 0) const;
     virtual String get_current_animation(int p_track = 0) const;
     virtual void reset();
+    virtual void recycle();
     virtual void seek(int track, float p_pos);
     virtual float tell(int track) const;
 
@@ -62,12 +95,19 @@ public:
     virtual bool has_attachment_node(const String& p_bone_name, const Variant& p_node);
 	virtual bool add_attachment_node(const String& p_bone_name, const Variant& p_node, const Vector2& p_ofs = Vector2(0, 0), const Vector2& p_scale = Vector2(1, 1), const real_t p_rot = 0);
 	virtual bool remove_attachment_node(const String& p_bone_name, const Variant& p_node);
+	virtual void _on_attachment_node_exiting(Object *p_node);
+	virtual void _on_attachment_node_entered(Object *p_node);
     
     virtual Ref<Shape2D> get_bounding_box(const String& p_slot_name, const String& p_attachment_name);
     virtual bool add_bounding_box(const String& p_bone_name, const String& p_slot_name, const String& p_attachment_name, const Variant& p_node, const Vector2& p_ofs = Vector2(0, 0), const Vector2& p_scale = Vector2(1, 1), const real_t p_rot = 0);
 
     virtual Vector2 get_bone_position(const String &bone_name);
     virtual float get_bone_rotation(const String &bone_name);
+    virtual bool set_bones_local(const PoolIntArray &p_bone_ids, const PoolVector2Array &p_positions, const PoolRealArray &p_rotations);
+
+    virtual bool play_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
+    virtual bool add_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
+    virtual Transform2D get_bone_world_by_id(int p_bone_id) const;
 
     SpineRuntime_4_0(Ref<SpineResource> resource);
     ~SpineRuntime_4_0();
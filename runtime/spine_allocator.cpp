@@ -0,0 +1,616 @@
+#include "spine_allocator.h"
+#include "spine_runtime.h"
+#include "core/hash_map.h"
+#include "core/os/file_access.h"
+#include "core/os/memory.h"
+#include "core/os/mutex.h"
+#include "core/vector.h"
+
+enum {
+    BLOCK_HEADER_SIZE = 16,
+    POOL_CLASSES = 5, // 16 .. 256 byte payloads
+    POOL_MIN_SHIFT = 4,
+    POOL_REFILL_SLOTS = 64,
+    // a thread's cache hands slots back to the shared pool past this
+    POOL_CACHE_SLOTS = 2 * POOL_REFILL_SLOTS,
+    ARENA_CHUNK_HEADER_SIZE = 32,
+    ARENA_CHUNK_SIZE = 16384,
+    TAG_HEAP = 0xff,
+    TAG_ARENA = 0xfe,
+};
+
+// A free pool slot keeps its next pointer over tag and size; chunk stays
+// set from the slot's carving for trim_pools().
+struct SpineBlockHeader {
+    uint32_t tag;
+    uint32_t size;
+    uint32_t site;
+    uint32_t chunk;
+};
+
+// Slots a thread freed and reuses without locking. Flushed to the shared
+// pool when the thread exits, so worker threads don't strand their chunks.
+struct SpinePoolCache {
+    void *lists[POOL_CLASSES];
+    int counts[POOL_CLASSES];
+
+    ~SpinePoolCache();
+};
+
+static SpineAllocator::Mode allocator_mode = SpineAllocator::MODE_HEAP;
+static bool allocator_tracking = false;
+// heap mode without tracking hands out plain memalloc blocks
+static bool allocator_headers = false;
+static thread_local SpinePoolCache pool_cache;
+// slots given back by threads, and every chunk carved so far per class
+static Mutex pool_mutex;
+static void *pool_shared_lists[POOL_CLASSES];
+static int pool_shared_counts[POOL_CLASSES];
+static Vector<uint8_t *> pool_chunks[POOL_CLASSES];
+static thread_local SpineAllocator::Arena *current_arena = NULL;
+static thread_local SpineAllocator::MeasureScope *current_measure = NULL;
+
+static SafeNumeric<uint64_t> stat_heap_allocs;
+static SafeNumeric<uint64_t> stat_pool_allocs;
+static SafeNumeric<uint64_t> stat_pool_refills;
+static SafeNumeric<uint64_t> stat_pool_reserved;
+static SafeNumeric<uint64_t> stat_arena_allocs;
+static SafeNumeric<uint64_t> stat_arena_bytes;
+static SafeNumeric<uint64_t> stat_reallocs;
+static SafeNumeric<uint64_t> stat_frees;
+
+// Allocation call sites, indexed by SpineBlockHeader::site. Site 0 collects
+// blocks allocated without a known origin.
+struct SpineAllocationSite {
+    const char *file;
+    int line;
+    const char *version;
+    uint64_t live_bytes;
+    uint64_t peak_bytes;
+    uint64_t allocs;
+    uint64_t frees;
+};
+
+struct SpineSiteKey {
+    const char *file;
+    int line;
+    const char *version;
+};
+
+struct SpineSiteKeyHasher {
+    static _FORCE_INLINE_ uint32_t hash(const SpineSiteKey &p_key) {
+        uint32_t h = hash_djb2_one_64((uint64_t)p_key.file);
+        h = hash_djb2_one_64((uint64_t)p_key.version, h);
+        return hash_djb2_one_32((uint32_t)p_key.line, h);
+    }
+};
+
+struct SpineSiteKeyComparator {
+    static _FORCE_INLINE_ bool compare(const SpineSiteKey &p_lhs, const SpineSiteKey &p_rhs) {
+        return p_lhs.file == p_rhs.file && p_lhs.line == p_rhs.line && p_lhs.version == p_rhs.version;
+    }
+};
+
+static Mutex site_mutex;
+static Vector<SpineAllocationSite> sites;
+static HashMap<SpineSiteKey, uint32_t, SpineSiteKeyHasher, SpineSiteKeyComparator> site_ids;
+
+static uint32_t spine_track_alloc(const char *p_file, int p_line, const char *p_version, size_t p_size) {
+    MutexLock lock(site_mutex);
+    SpineSiteKey key = { p_file, p_line, p_version };
+    const uint32_t *id = site_ids.getptr(key);
+    uint32_t site;
+    if (id) {
+        site = *id;
+    } else {
+        SpineAllocationSite entry = { p_file, p_line, p_version, 0, 0, 0, 0 };
+        site = sites.size();
+        sites.push_back(entry);
+        site_ids.set(key, site);
+    }
+    SpineAllocationSite &entry = sites.write[site];
+    entry.live_bytes += p_size;
+    entry.peak_bytes = MAX(entry.peak_bytes, entry.live_bytes);
+    entry.allocs++;
+    return site;
+}
+
+static void spine_track_free(uint32_t p_site, size_t p_size) {
+    MutexLock lock(site_mutex);
+    ERR_FAIL_INDEX(p_site, (uint32_t)sites.size());
+    SpineAllocationSite &entry = sites.write[p_site];
+    entry.live_bytes -= MIN((uint64_t)p_size, entry.live_bytes);
+    entry.frees++;
+}
+
+static void spine_track_resize(uint32_t p_site, size_t p_old_size, size_t p_new_size) {
+    MutexLock lock(site_mutex);
+    ERR_FAIL_INDEX(p_site, (uint32_t)sites.size());
+    SpineAllocationSite &entry = sites.write[p_site];
+    entry.live_bytes += p_new_size - MIN((uint64_t)p_old_size, entry.live_bytes);
+    entry.peak_bytes = MAX(entry.peak_bytes, entry.live_bytes);
+}
+
+static _FORCE_INLINE_ size_t spine_align(size_t p_size) {
+    return (p_size + 15) & ~(size_t)15;
+}
+
+static _FORCE_INLINE_ int spine_pool_class(size_t p_size) {
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        if (p_size <= ((size_t)1 << (POOL_MIN_SHIFT + i))) return i;
+    }
+    return -1;
+}
+
+static _FORCE_INLINE_ size_t spine_pool_slot_size(int p_class) {
+    return BLOCK_HEADER_SIZE + ((size_t)1 << (POOL_MIN_SHIFT + p_class));
+}
+
+// Moves up to p_count slots from the front of list p_from onto p_to.
+static int spine_pool_move(void *&p_from, void *&p_to, int p_count) {
+    int moved = 0;
+    while (p_from && moved < p_count) {
+        void *slot = p_from;
+        p_from = *(void **)slot;
+        *(void **)slot = p_to;
+        p_to = slot;
+        moved++;
+    }
+    return moved;
+}
+
+// Refills the calling thread's cache from the shared pool, or from a new
+// chunk when the pool has none.
+static void spine_pool_refill(int p_class) {
+    MutexLock lock(pool_mutex);
+    if (pool_shared_lists[p_class]) {
+        int moved = spine_pool_move(pool_shared_lists[p_class], pool_cache.lists[p_class], POOL_REFILL_SLOTS);
+        pool_shared_counts[p_class] -= moved;
+        pool_cache.counts[p_class] += moved;
+        return;
+    }
+    size_t slot_size = spine_pool_slot_size(p_class);
+    uint8_t *chunk = (uint8_t *)memalloc(slot_size * POOL_REFILL_SLOTS);
+    Vector<uint8_t *> &chunks = pool_chunks[p_class];
+    int chunk_id = chunks.find((uint8_t *)NULL);
+    if (chunk_id < 0) {
+        chunk_id = chunks.size();
+        chunks.push_back(chunk);
+    } else {
+        chunks.write[chunk_id] = chunk;
+    }
+    void *slot = pool_cache.lists[p_class];
+    for (int i = POOL_REFILL_SLOTS - 1; i >= 0; i--) {
+        ((SpineBlockHeader *)(chunk + i * slot_size))->chunk = chunk_id;
+        *(void **)(chunk + i * slot_size) = slot;
+        slot = chunk + i * slot_size;
+    }
+    pool_cache.lists[p_class] = slot;
+    pool_cache.counts[p_class] += POOL_REFILL_SLOTS;
+    stat_pool_refills.increment();
+    stat_pool_reserved.add(slot_size * POOL_REFILL_SLOTS);
+}
+
+static SpineBlockHeader *spine_pool_pop(int p_class) {
+    if (pool_cache.lists[p_class] == NULL) {
+        spine_pool_refill(p_class);
+    }
+    void *slot = pool_cache.lists[p_class];
+    pool_cache.lists[p_class] = *(void **)slot;
+    pool_cache.counts[p_class]--;
+    return (SpineBlockHeader *)slot;
+}
+
+// Gives up to p_count of the calling thread's cached slots to the shared
+// pool, all of them with -1.
+static void spine_pool_flush(int p_class, int p_count) {
+    MutexLock lock(pool_mutex);
+    int moved = spine_pool_move(pool_cache.lists[p_class], pool_shared_lists[p_class], p_count < 0 ? pool_cache.counts[p_class] : p_count);
+    pool_cache.counts[p_class] -= moved;
+    pool_shared_counts[p_class] += moved;
+}
+
+static void spine_pool_push(int p_class, SpineBlockHeader *p_header) {
+    *(void **)p_header = pool_cache.lists[p_class];
+    pool_cache.lists[p_class] = p_header;
+    // blocks freed by another thread than the one that allocated them
+    // would otherwise pile up here
+    if (++pool_cache.counts[p_class] > POOL_CACHE_SLOTS) {
+        spine_pool_flush(p_class, POOL_REFILL_SLOTS);
+    }
+}
+
+SpinePoolCache::~SpinePoolCache() {
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        if (lists[i]) {
+            spine_pool_flush(i, -1);
+        }
+    }
+}
+
+void *SpineAllocator::Arena::alloc(size_t p_size) {
+    p_size = spine_align(p_size);
+    if (blocks == NULL || blocks->used + p_size > blocks->capacity) {
+        size_t capacity = MAX((size_t)ARENA_CHUNK_SIZE, p_size);
+        Block *block = (Block *)memalloc(ARENA_CHUNK_HEADER_SIZE + capacity);
+        block->next = blocks;
+        block->used = 0;
+        block->capacity = capacity;
+        blocks = block;
+    }
+    void *ptr = (uint8_t *)blocks + ARENA_CHUNK_HEADER_SIZE + blocks->used;
+    blocks->used += p_size;
+    stat_arena_bytes.add(p_size);
+    return ptr;
+}
+
+size_t SpineAllocator::Arena::get_reserved() const {
+    size_t reserved = 0;
+    for (Block *block = blocks; block; block = block->next) {
+        reserved += ARENA_CHUNK_HEADER_SIZE + block->capacity;
+    }
+    return reserved;
+}
+
+void SpineAllocator::Arena::clear() {
+    while (blocks) {
+        Block *next = blocks->next;
+        memfree(blocks);
+        blocks = next;
+    }
+}
+
+SpineAllocator::Arena::Arena() {
+    blocks = NULL;
+}
+
+SpineAllocator::Arena::~Arena() {
+    clear();
+}
+
+SpineAllocator::ArenaScope::ArenaScope(Arena *p_arena) {
+    previous = current_arena;
+    if (allocator_mode == MODE_POOLS_AND_ARENAS) {
+        current_arena = p_arena;
+    }
+}
+
+SpineAllocator::ArenaScope::~ArenaScope() {
+    current_arena = previous;
+}
+
+uint64_t SpineAllocator::MeasureScope::get_bytes() const {
+    return bytes > 0 ? bytes : 0;
+}
+
+SpineAllocator::MeasureScope::MeasureScope() {
+    previous = current_measure;
+    bytes = 0;
+    current_measure = this;
+}
+
+SpineAllocator::MeasureScope::~MeasureScope() {
+    current_measure = previous;
+    if (previous) {
+        previous->bytes += bytes;
+    }
+}
+
+// Must run before the runtimes allocate anything: heap blocks carry no
+// header and can't be told apart from pooled ones afterwards.
+void SpineAllocator::init(Mode p_mode, bool p_track) {
+    allocator_mode = p_mode;
+    allocator_tracking = p_track;
+    allocator_headers = p_mode != MODE_HEAP || p_track;
+    if (p_track && sites.empty()) {
+        SpineAllocationSite unknown = { NULL, 0, NULL, 0, 0, 0, 0 };
+        sites.push_back(unknown);
+    }
+}
+
+SpineAllocator::Mode SpineAllocator::get_mode() {
+    return allocator_mode;
+}
+
+bool SpineAllocator::is_tracking() {
+    return allocator_tracking;
+}
+
+void *SpineAllocator::alloc(size_t p_size, const char *p_file, int p_line, const char *p_version) {
+    if (p_size == 0) return NULL;
+    if (!allocator_headers) {
+        stat_heap_allocs.increment();
+        return memalloc(p_size);
+    }
+    SpineBlockHeader *header;
+    int pool_class = allocator_mode == MODE_HEAP ? -1 : spine_pool_class(p_size);
+    if (current_arena) {
+        header = (SpineBlockHeader *)current_arena->alloc(BLOCK_HEADER_SIZE + p_size);
+        header->tag = TAG_ARENA;
+        stat_arena_allocs.increment();
+    } else if (pool_class >= 0) {
+        header = spine_pool_pop(pool_class);
+        header->tag = pool_class;
+        stat_pool_allocs.increment();
+    } else {
+        header = (SpineBlockHeader *)memalloc(BLOCK_HEADER_SIZE + p_size);
+        header->tag = TAG_HEAP;
+        stat_heap_allocs.increment();
+    }
+    header->size = p_size;
+    header->site = allocator_tracking ? spine_track_alloc(p_file, p_line, p_version, p_size) : 0;
+    if (current_measure) {
+        current_measure->bytes += p_size;
+    }
+    return header + 1;
+}
+
+void *SpineAllocator::calloc(size_t p_size, const char *p_file, int p_line, const char *p_version) {
+    void *ptr = alloc(p_size, p_file, p_line, p_version);
+    if (ptr) {
+        memset(ptr, 0, p_size);
+    }
+    return ptr;
+}
+
+// Blocks that are grown in place stay attributed to their original site.
+void *SpineAllocator::realloc(void *p_ptr, size_t p_size, const char *p_file, int p_line, const char *p_version) {
+    if (p_size == 0) return NULL;
+    if (p_ptr == NULL) return alloc(p_size, p_file, p_line, p_version);
+    stat_reallocs.increment();
+    if (!allocator_headers) {
+        return memrealloc(p_ptr, p_size);
+    }
+    SpineBlockHeader *header = (SpineBlockHeader *)p_ptr - 1;
+    int pool_class = allocator_mode == MODE_HEAP ? -1 : spine_pool_class(p_size);
+    bool in_place = current_arena == NULL && ((header->tag == TAG_HEAP && pool_class < 0) || (header->tag < POOL_CLASSES && pool_class == (int)header->tag));
+    if (in_place) {
+        if (allocator_tracking) {
+            spine_track_resize(header->site, header->size, p_size);
+        }
+        if (current_measure) {
+            current_measure->bytes += (int64_t)p_size - (int64_t)header->size;
+        }
+        if (header->tag == TAG_HEAP) {
+            header = (SpineBlockHeader *)memrealloc(header, BLOCK_HEADER_SIZE + p_size);
+        }
+        header->size = p_size;
+        return header + 1;
+    }
+    void *ptr = alloc(p_size, p_file, p_line, p_version);
+    memcpy(ptr, p_ptr, MIN((size_t)header->size, p_size));
+    free(p_ptr);
+    return ptr;
+}
+
+void SpineAllocator::free(void *p_ptr) {
+    if (p_ptr == NULL) return;
+    stat_frees.increment();
+    if (!allocator_headers) {
+        memfree(p_ptr);
+        return;
+    }
+    SpineBlockHeader *header = (SpineBlockHeader *)p_ptr - 1;
+    if (allocator_tracking) {
+        spine_track_free(header->site, header->size);
+    }
+    if (current_measure) {
+        current_measure->bytes -= header->size;
+    }
+    if (header->tag == TAG_HEAP) {
+        memfree(header);
+    } else if (header->tag < POOL_CLASSES) {
+        spine_pool_push(header->tag, header);
+    }
+    // arena blocks are released with their arena
+}
+
+// Hands the calling thread's cached slots to the shared pool and frees the
+// chunks whose slots are all there. Slots cached by other threads keep
+// their chunks. Returns the bytes released.
+uint64_t SpineAllocator::trim_pools() {
+    uint64_t released = 0;
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        spine_pool_flush(i, -1);
+    }
+    MutexLock lock(pool_mutex);
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        Vector<uint8_t *> &chunks = pool_chunks[i];
+        if (pool_shared_counts[i] < POOL_REFILL_SLOTS) continue;
+        Vector<int> free_slots;
+        free_slots.resize(chunks.size());
+        for (int j = 0; j < free_slots.size(); j++) {
+            free_slots.write[j] = 0;
+        }
+        for (void *slot = pool_shared_lists[i]; slot; slot = *(void **)slot) {
+            free_slots.write[((SpineBlockHeader *)slot)->chunk]++;
+        }
+        void *kept = NULL;
+        int kept_count = 0;
+        while (pool_shared_lists[i]) {
+            void *slot = pool_shared_lists[i];
+            pool_shared_lists[i] = *(void **)slot;
+            if (free_slots[((SpineBlockHeader *)slot)->chunk] < POOL_REFILL_SLOTS) {
+                *(void **)slot = kept;
+                kept = slot;
+                kept_count++;
+            }
+        }
+        pool_shared_lists[i] = kept;
+        pool_shared_counts[i] = kept_count;
+        size_t chunk_size = spine_pool_slot_size(i) * POOL_REFILL_SLOTS;
+        for (int j = 0; j < chunks.size(); j++) {
+            if (chunks[j] && free_slots[j] == POOL_REFILL_SLOTS) {
+                memfree(chunks[j]);
+                chunks.write[j] = NULL;
+                released += chunk_size;
+            }
+        }
+    }
+    stat_pool_reserved.sub(released);
+    return released;
+}
+
+Dictionary SpineAllocator::get_stats() {
+    Dictionary stats;
+    stats["mode"] = allocator_mode;
+    stats["heap_allocs"] = stat_heap_allocs.get();
+    stats["pool_allocs"] = stat_pool_allocs.get();
+    stats["pool_refills"] = stat_pool_refills.get();
+    stats["pool_reserved"] = stat_pool_reserved.get();
+    stats["arena_allocs"] = stat_arena_allocs.get();
+    stats["arena_bytes"] = stat_arena_bytes.get();
+    stats["reallocs"] = stat_reallocs.get();
+    stats["frees"] = stat_frees.get();
+    return stats;
+}
+
+// pool_reserved tracks memory still held and is not reset
+void SpineAllocator::reset_stats() {
+    stat_heap_allocs.set(0);
+    stat_pool_allocs.set(0);
+    stat_pool_refills.set(0);
+    stat_arena_allocs.set(0);
+    stat_arena_bytes.set(0);
+    stat_reallocs.set(0);
+    stat_frees.set(0);
+}
+
+static Dictionary spine_site_info(const SpineAllocationSite &p_site) {
+    Dictionary info;
+    info["file"] = p_site.file ? String(p_site.file) : String("<unknown>");
+    info["line"] = p_site.line;
+    info["version"] = p_site.version ? String(p_site.version) : String("<unknown>");
+    info["live_bytes"] = p_site.live_bytes;
+    info["peak_bytes"] = p_site.peak_bytes;
+    info["allocs"] = p_site.allocs;
+    info["frees"] = p_site.frees;
+    return info;
+}
+
+struct SpineSiteLiveSort {
+    _FORCE_INLINE_ bool operator()(const Variant &p_a, const Variant &p_b) const {
+        return (uint64_t)((Dictionary)p_a)["live_bytes"] > (uint64_t)((Dictionary)p_b)["live_bytes"];
+    }
+};
+
+// One entry per call site, largest live usage first.
+Array SpineAllocator::get_sites() {
+    Array result;
+    ERR_FAIL_COND_V_MSG(!allocator_tracking, result, "Enable spine/memory/track_allocations to record allocation sites");
+    MutexLock lock(site_mutex);
+    for (int i = 0; i < sites.size(); i++) {
+        if (sites[i].allocs) {
+            result.push_back(spine_site_info(sites[i]));
+        }
+    }
+    result.sort_custom<SpineSiteLiveSort>();
+    return result;
+}
+
+// Site totals summed per runtime version. Peaks are the sum of per-site peaks.
+Dictionary SpineAllocator::get_versions() {
+    Dictionary result;
+    Array all = get_sites();
+    for (int i = 0; i < all.size(); i++) {
+        Dictionary site = all[i];
+        Dictionary version = result.get(site["version"], Dictionary());
+        const char *keys[] = { "live_bytes", "peak_bytes", "allocs", "frees" };
+        for (int k = 0; k < 4; k++) {
+            version[keys[k]] = (uint64_t)version.get(keys[k], 0) + (uint64_t)site[keys[k]];
+        }
+        result[site["version"]] = version;
+    }
+    return result;
+}
+
+Error SpineAllocator::dump_sites(const String &p_path) {
+    ERR_FAIL_COND_V_MSG(!allocator_tracking, ERR_UNAVAILABLE, "Enable spine/memory/track_allocations to record allocation sites");
+    Array all = get_sites();
+    Error err;
+    FileAccess *f = FileAccess::open(p_path, FileAccess::WRITE, &err);
+    ERR_FAIL_COND_V_MSG(!f, err, "Can't write spine allocation dump: " + p_path);
+    f->store_line("version,file,line,live_bytes,peak_bytes,allocs,frees");
+    for (int i = 0; i < all.size(); i++) {
+        Dictionary site = all[i];
+        f->store_line(String(site["version"]) + "," + String(site["file"]) + "," + itos(site["line"]) + "," +
+                String::num_uint64(site["live_bytes"]) + "," + String::num_uint64(site["peak_bytes"]) + "," +
+                String::num_uint64(site["allocs"]) + "," + String::num_uint64(site["frees"]));
+    }
+    f->close();
+    memdelete(f);
+    return OK;
+}
+
+SpineMemory *SpineMemory::singleton = NULL;
+
+SpineMemory *SpineMemory::get_singleton() {
+    return singleton;
+}
+
+int SpineMemory::get_allocator_mode() const {
+    return SpineAllocator::get_mode();
+}
+
+Dictionary SpineMemory::get_allocator_stats() const {
+    return SpineAllocator::get_stats();
+}
+
+void SpineMemory::reset_allocator_stats() {
+    SpineAllocator::reset_stats();
+}
+
+bool SpineMemory::is_tracking_allocations() const {
+    return SpineAllocator::is_tracking();
+}
+
+Array SpineMemory::get_allocation_sites() const {
+    return SpineAllocator::get_sites();
+}
+
+Dictionary SpineMemory::get_allocation_versions() const {
+    return SpineAllocator::get_versions();
+}
+
+Error SpineMemory::dump_allocations(const String &p_path) const {
+    return SpineAllocator::dump_sites(p_path);
+}
+
+Dictionary SpineMemory::get_load_report() const {
+    return SpineRuntime::get_load_report();
+}
+
+void SpineMemory::reset_load_report() {
+    SpineRuntime::reset_load_report();
+}
+
+Dictionary SpineMemory::get_texture_stats() const {
+    return SpineRuntime::get_page_stats();
+}
+
+int SpineMemory::evict_textures(float p_unused_seconds) {
+    return SpineRuntime::evict_pages((uint64_t)(p_unused_seconds * 1000), 0);
+}
+
+uint64_t SpineMemory::trim_allocator_pools() {
+    return SpineAllocator::trim_pools();
+}
+
+void SpineMemory::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_allocator_mode"), &SpineMemory::get_allocator_mode);
+    ClassDB::bind_method(D_METHOD("get_allocator_stats"), &SpineMemory::get_allocator_stats);
+    ClassDB::bind_method(D_METHOD("reset_allocator_stats"), &SpineMemory::reset_allocator_stats);
+    ClassDB::bind_method(D_METHOD("is_tracking_allocations"), &SpineMemory::is_tracking_allocations);
+    ClassDB::bind_method(D_METHOD("get_allocation_sites"), &SpineMemory::get_allocation_sites);
+    ClassDB::bind_method(D_METHOD("get_allocation_versions"), &SpineMemory::get_allocation_versions);
+    ClassDB::bind_method(D_METHOD("dump_allocations", "path"), &SpineMemory::dump_allocations);
+    ClassDB::bind_method(D_METHOD("get_load_report"), &SpineMemory::get_load_report);
+    ClassDB::bind_method(D_METHOD("reset_load_report"), &SpineMemory::reset_load_report);
+    ClassDB::bind_method(D_METHOD("get_texture_stats"), &SpineMemory::get_texture_stats);
+    ClassDB::bind_method(D_METHOD("evict_textures", "unused_seconds"), &SpineMemory::evict_textures, 0.0);
+    ClassDB::bind_method(D_METHOD("trim_allocator_pools"), &SpineMemory::trim_allocator_pools);
+}
+
+SpineMemory::SpineMemory() {
+    singleton = this;
+}
@@ -0,0 +1,116 @@
+#ifndef SPINE_ALLOCATOR_H
+#define SPINE_ALLOCATOR_H
+
+#include "core/array.h"
+#include "core/dictionary.h"
+#include "core/object.h"
+#include "core/safe_refcount.h"
+
+// Allocator behind the spine runtimes' memory hooks. In heap mode it
+// forwards to memalloc. Otherwise every block carries a small header naming
+// its origin: small blocks come from size-class pools with a per-thread
+// cache in front, and
+// blocks allocated inside an ArenaScope come from that arena and are only
+// released with it. With tracking enabled every block also records the
+// call site and runtime version that allocated it.
+class SpineAllocator {
+public:
+    enum Mode {
+        MODE_HEAP,
+        MODE_POOLS,
+        MODE_POOLS_AND_ARENAS,
+    };
+
+    // Bump allocator for objects that live exactly as long as its owner.
+    class Arena {
+        struct Block {
+            Block *next;
+            size_t used;
+            size_t capacity;
+        };
+        Block *blocks;
+
+    public:
+        void *alloc(size_t p_size);
+        size_t get_reserved() const;
+        void clear();
+
+        Arena();
+        ~Arena();
+    };
+
+    // Routes allocations made on the calling thread to p_arena.
+    class ArenaScope {
+        Arena *previous;
+
+    public:
+        ArenaScope(Arena *p_arena);
+        ~ArenaScope();
+    };
+
+    // Net bytes allocated on the calling thread while it is alive, used to
+    // attribute a load's memory to its resource. Inner scopes add to the
+    // outer one. Counts nothing in heap mode without tracking, where blocks
+    // don't record their size.
+    class MeasureScope {
+        MeasureScope *previous;
+        int64_t bytes;
+
+    public:
+        uint64_t get_bytes() const;
+
+        MeasureScope();
+        ~MeasureScope();
+    };
+
+    static void init(Mode p_mode, bool p_track);
+    static Mode get_mode();
+    static bool is_tracking();
+
+    static void *alloc(size_t p_size, const char *p_file = NULL, int p_line = 0, const char *p_version = NULL);
+    static void *calloc(size_t p_size, const char *p_file = NULL, int p_line = 0, const char *p_version = NULL);
+    static void *realloc(void *p_ptr, size_t p_size, const char *p_file = NULL, int p_line = 0, const char *p_version = NULL);
+    static void free(void *p_ptr);
+    // releases pool chunks nothing uses, see the definition
+    static uint64_t trim_pools();
+
+    static Dictionary get_stats();
+    static void reset_stats();
+
+    static Array get_sites();
+    static Dictionary get_versions();
+    static Error dump_sites(const String &p_path);
+};
+
+// GDScript access to spine runtime memory statistics.
+class SpineMemory : public Object {
+    GDCLASS(SpineMemory, Object);
+
+    static SpineMemory *singleton;
+
+protected:
+    static void _bind_methods();
+
+public:
+    static SpineMemory *get_singleton();
+
+    int get_allocator_mode() const;
+    Dictionary get_allocator_stats() const;
+    void reset_allocator_stats();
+
+    bool is_tracking_allocations() const;
+    Array get_allocation_sites() const;
+    Dictionary get_allocation_versions() const;
+    Error dump_allocations(const String &p_path) const;
+
+    Dictionary get_load_report() const;
+    void reset_load_report();
+
+    Dictionary get_texture_stats() const;
+    int evict_textures(float p_unused_seconds);
+    uint64_t trim_allocator_pools();
+
+    SpineMemory();
+};
+
+#endif
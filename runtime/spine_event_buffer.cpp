@@ -0,0 +1,38 @@
+#include "spine_event_buffer.h"
+
+void SpineEventBuffer::set_capacity(int p_capacity) {
+    int capacity = next_power_of_2(MAX(p_capacity, 1));
+    if (capacity == ring.size()) return;
+    ring.resize(capacity);
+    mask = capacity - 1;
+    // pending events did not survive the resize
+    start = sequence;
+}
+
+int SpineEventBuffer::get_capacity() const {
+    return ring.size();
+}
+
+void SpineEventBuffer::push(const Event &p_event) {
+    ring.write[sequence & mask] = p_event;
+    sequence++;
+}
+
+const SpineEventBuffer::Event *SpineEventBuffer::read(uint64_t &r_cursor) {
+    if (r_cursor >= sequence) return NULL;
+    uint64_t capacity = mask + 1;
+    uint64_t first = MAX(start, sequence > capacity ? sequence - capacity : 0);
+    if (r_cursor < first) {
+        dropped += first - r_cursor;
+        r_cursor = first;
+    }
+    return &ring[r_cursor++ & mask];
+}
+
+SpineEventBuffer::SpineEventBuffer() {
+    mask = 0;
+    sequence = 0;
+    start = 0;
+    dropped = 0;
+    set_capacity(256);
+}
@@ -0,0 +1,52 @@
+#ifndef SPINE_EVENT_BUFFER_H
+#define SPINE_EVENT_BUFFER_H
+
+#include "core/vector.h"
+
+// Fixed size ring of animation state events written by a runtime during
+// update/apply. Readers keep their own sequence cursor, so several consumers
+// (signals, polling) can drain the same events independently. When a reader
+// falls more than the capacity behind, the oldest events are dropped.
+class SpineEventBuffer {
+public:
+    enum Type {
+        EVENT_START,
+        EVENT_COMPLETE,
+        EVENT_EVENT,
+        EVENT_END,
+    };
+
+    struct Event {
+        Type type;
+        int track;
+        // index into SpineResource::event_names, -1 for track events
+        int name;
+        // loop count for EVENT_COMPLETE
+        int int_value;
+        float float_value;
+        // owned by the skeleton data, valid while the resource is alive
+        const char *string_value;
+    };
+
+private:
+    Vector<Event> ring;
+    uint64_t mask;
+    uint64_t sequence;
+    uint64_t start;
+    uint64_t dropped;
+
+public:
+    void set_capacity(int p_capacity);
+    int get_capacity() const;
+
+    _FORCE_INLINE_ uint64_t get_sequence() const { return sequence; }
+    _FORCE_INLINE_ uint64_t get_dropped() const { return dropped; }
+
+    void push(const Event &p_event);
+    // Returns the event at r_cursor and advances it, or NULL when drained.
+    const Event *read(uint64_t &r_cursor);
+
+    SpineEventBuffer();
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "spine_pose_cache.h"
+
+void SpinePoseCache::_evict(int p_required) {
+    while (lru.size() && memory_used + p_required > memory_limit) {
+        List<Key>::Element *E = lru.front();
+        Entry *entry = entries.getptr(E->get());
+        if (entry) {
+            memory_used -= entry->pose.size() * sizeof(float);
+            entries.erase(E->get());
+        }
+        lru.erase(E);
+    }
+}
+
+void SpinePoseCache::set_memory_limit(int p_bytes) {
+    memory_limit = MAX(p_bytes, 0);
+    _evict(0);
+}
+
+int SpinePoseCache::get_memory_limit() const {
+    return memory_limit;
+}
+
+void SpinePoseCache::set_fps(float p_fps) {
+    if (fps == p_fps) return;
+    fps = MAX(p_fps, 0);
+    // frame indexes are meaningless after the step changes
+    clear();
+}
+
+float SpinePoseCache::get_fps() const {
+    return fps;
+}
+
+const float *SpinePoseCache::get(const Key &p_key) {
+    Entry *entry = entries.getptr(p_key);
+    if (!entry) {
+        misses++;
+        return NULL;
+    }
+    hits++;
+    lru.move_to_back(entry->lru);
+    return entry->pose.ptr();
+}
+
+void SpinePoseCache::store(const Key &p_key, const float *p_pose, int p_count) {
+    int bytes = p_count * sizeof(float);
+    if (bytes > memory_limit) return;
+
+    Entry *entry = entries.getptr(p_key);
+    if (entry) {
+        memory_used -= entry->pose.size() * sizeof(float);
+        lru.erase(entry->lru);
+        entries.erase(p_key);
+    }
+    _evict(bytes);
+
+    Entry new_entry;
+    new_entry.pose.resize(p_count);
+    memcpy(new_entry.pose.ptrw(), p_pose, bytes);
+    new_entry.lru = lru.push_back(p_key);
+    entries.set(p_key, new_entry);
+    memory_used += bytes;
+}
+
+void SpinePoseCache::clear() {
+    entries.clear();
+    lru.clear();
+    memory_used = 0;
+}
+
+Dictionary SpinePoseCache::get_stats() const {
+    Dictionary stats;
+    stats["hits"] = hits;
+    stats["misses"] = misses;
+    stats["entries"] = lru.size();
+    stats["memory_used"] = memory_used;
+    stats["memory_limit"] = memory_limit;
+    return stats;
+}
+
+SpinePoseCache::SpinePoseCache() {
+    memory_limit = 0;
+    memory_used = 0;
+    fps = 60;
+    hits = 0;
+    misses = 0;
+}
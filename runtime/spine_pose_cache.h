@@ -0,0 +1,74 @@
+#ifndef SPINE_POSE_CACHE_H
+#define SPINE_POSE_CACHE_H
+
+#include "core/hash_map.h"
+#include "core/list.h"
+#include "core/dictionary.h"
+#include "core/vector.h"
+#include "core/math/math_funcs.h"
+
+// LRU cache of computed bone world transforms, shared by all runtimes
+// of a SpineResource. Poses are keyed by skin, animation and track time
+// quantized to 1/fps, and stored as 6 floats per bone (a, b, c, d, worldX, worldY).
+class SpinePoseCache {
+public:
+    enum {
+        FLOATS_PER_BONE = 6
+    };
+
+    struct Key {
+        const void *skin;
+        const void *animation;
+        int frame;
+    };
+
+private:
+    struct KeyHasher {
+        static _FORCE_INLINE_ uint32_t hash(const Key &p_key) {
+            uint32_t h = hash_djb2_one_64((uint64_t)p_key.skin);
+            h = hash_djb2_one_64((uint64_t)p_key.animation, h);
+            return hash_djb2_one_32((uint32_t)p_key.frame, h);
+        }
+    };
+
+    struct KeyComparator {
+        static _FORCE_INLINE_ bool compare(const Key &p_lhs, const Key &p_rhs) {
+            return p_lhs.skin == p_rhs.skin && p_lhs.animation == p_rhs.animation && p_lhs.frame == p_rhs.frame;
+        }
+    };
+
+    struct Entry {
+        Vector<float> pose;
+        List<Key>::Element *lru;
+    };
+
+    HashMap<Key, Entry, KeyHasher, KeyComparator> entries;
+    List<Key> lru;
+
+    int memory_limit;
+    int memory_used;
+    float fps;
+    uint64_t hits;
+    uint64_t misses;
+
+    void _evict(int p_required);
+
+public:
+    _FORCE_INLINE_ bool is_enabled() const { return memory_limit > 0 && fps > 0; }
+    _FORCE_INLINE_ int quantize(float p_time) const { return (int)Math::round(p_time * fps); }
+
+    void set_memory_limit(int p_bytes);
+    int get_memory_limit() const;
+    void set_fps(float p_fps);
+    float get_fps() const;
+
+    const float *get(const Key &p_key);
+    void store(const Key &p_key, const float *p_pose, int p_count);
+    void clear();
+
+    Dictionary get_stats() const;
+
+    SpinePoseCache();
+};
+
+#endif
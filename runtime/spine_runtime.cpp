@@ -14,7 +14,52 @@
 #ifdef SPINE_RUNTIME_4_1_ENABLED
 #include "spine_4_1/runtime.h"
 #endif
+#include "core/engine.h"
+#include "core/io/json.h"
+#include "core/io/marshalls.h"
+#include "core/io/resource_loader.h"
 #include "core/os/file_access.h"
+#include "core/os/mutex.h"
+#include "core/os/os.h"
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
+#include "core/project_settings.h"
+#include "core/safe_refcount.h"
+#include "scene/2d/canvas_item.h"
+
+// Calls static method CALL of the runtime class matching runtime_version,
+// prefixed with RET (`return` or nothing). Expands to an if/else chain that
+// the caller closes with the block run when no compiled-in runtime matches.
+#ifdef SPINE_RUNTIME_3_6_ENABLED
+#define SPINE_DISPATCH_3_6(RET, CALL) if (runtime_version == "3_6") { RET SpineRuntime_3_6::CALL; } else
+#else
+#define SPINE_DISPATCH_3_6(RET, CALL)
+#endif
+#ifdef SPINE_RUNTIME_3_7_ENABLED
+#define SPINE_DISPATCH_3_7(RET, CALL) if (runtime_version == "3_7") { RET SpineRuntime_3_7::CALL; } else
+#else
+#define SPINE_DISPATCH_3_7(RET, CALL)
+#endif
+#ifdef SPINE_RUNTIME_3_8_ENABLED
+#define SPINE_DISPATCH_3_8(RET, CALL) if (runtime_version == "3_8") { RET SpineRuntime_3_8::CALL; } else
+#else
+#define SPINE_DISPATCH_3_8(RET, CALL)
+#endif
+#ifdef SPINE_RUNTIME_4_0_ENABLED
+#define SPINE_DISPATCH_4_0(RET, CALL) if (runtime_version == "4_0") { RET SpineRuntime_4_0::CALL; } else
+#else
+#define SPINE_DISPATCH_4_0(RET, CALL)
+#endif
+#ifdef SPINE_RUNTIME_4_1_ENABLED
+#define SPINE_DISPATCH_4_1(RET, CALL) if (runtime_version == "4_1") { RET SpineRuntime_4_1::CALL; } else
+#else
+#define SPINE_DISPATCH_4_1(RET, CALL)
+#endif
+#define SPINE_RESOURCE_DISPATCH(RET, CALL) \
+    SPINE_DISPATCH_3_6(RET, CALL) SPINE_DISPATCH_3_7(RET, CALL) SPINE_DISPATCH_3_8(RET, CALL) \
+    SPINE_DISPATCH_4_0(RET, CALL) SPINE_DISPATCH_4_1(RET, CALL)
+
+static void spine_read_page_settings();
 
 void SpineRuntime::init() {
 #ifdef SPINE_RUNTIME_3_6_ENABLED    
@@ -32,118 +77,1694 @@ void SpineRuntime::init() {
 #ifdef SPINE_RUNTIME_4_1_ENABLED	
     SpineRuntime_4_1::init();
 #endif
+    spine_read_page_settings();
 }
 
-Ref<SpineResource> SpineRuntime::load_resource(const String &p_path) {
-    Ref<SpineResource> res;
-    if (p_path.ends_with(".json")) {
-        FileAccess* file = FileAccess::open(p_path, FileAccess::READ);
-        if (file == NULL) {
-            return res;
+// The "skeleton" header object comes first in exported json, so the
+// version probe never looks past this many bytes.
+#define SPINE_VERSION_PROBE_LIMIT 4096
+
+static SafeNumeric<uint64_t> load_count;
+static SafeNumeric<uint64_t> load_bytes;
+static SafeNumeric<uint64_t> load_read_usec;
+static SafeNumeric<uint64_t> load_parse_usec;
+static SafeNumeric<uint64_t> load_memory;
+static SafeNumeric<uint64_t> load_shared_atlases;
+
+// Every live atlas page; pages loaded off the main thread are also queued
+// in pending_pages until finalize_textures() creates their textures, and
+// lazy pages waiting for a deferred load in requested_pages.
+static Mutex pages_mutex;
+static Vector<SpinePage *> pages;
+static Vector<SpinePage *> pending_pages;
+// size of pending_pages, readable without the lock
+static SafeNumeric<uint32_t> pending_page_count;
+static Vector<SpinePage *> requested_pages;
+static uint64_t pages_frame = 0;
+static uint64_t pages_msec = 0;
+static uint64_t pages_next_eviction = 0;
+static uint64_t pages_evicted = 0;
+static uint64_t pages_loaded_lazily = 0;
+static uint64_t pages_variant_swaps = 0;
+static float pages_draw_scale = 1.0;
+static ObjectID pages_draw_owner = 0;
+
+// spine/textures/* settings used every frame. Godot 3 doesn't signal
+// project setting changes, so update_pages() reads them again once a second.
+struct SpinePageSettings {
+    bool lazy_pages;
+    int lazy_load_mode;
+    int deferred_loads_per_frame;
+    int memory_budget;
+    uint64_t evict_after_msec;
+    float variant_scale_bias;
+    float max_variant_scale;
+    uint64_t variant_downscale_delay_msec;
+};
+static SpinePageSettings page_settings;
+static uint64_t page_settings_next_read = 0;
+
+static void spine_read_page_settings() {
+    page_settings.lazy_pages = GLOBAL_GET("spine/textures/lazy_pages");
+    page_settings.lazy_load_mode = GLOBAL_GET("spine/textures/lazy_load_mode");
+    page_settings.deferred_loads_per_frame = GLOBAL_GET("spine/textures/deferred_loads_per_frame");
+    page_settings.memory_budget = GLOBAL_GET("spine/textures/memory_budget");
+    page_settings.evict_after_msec = (uint64_t)((float)GLOBAL_GET("spine/textures/evict_after") * 1000);
+    page_settings.variant_scale_bias = GLOBAL_GET("spine/textures/variant_scale_bias");
+    page_settings.max_variant_scale = GLOBAL_GET("spine/textures/max_variant_scale");
+    page_settings.variant_downscale_delay_msec = (uint64_t)((float)GLOBAL_GET("spine/textures/variant_downscale_delay") * 1000);
+}
+
+enum SpinePageLoadMode {
+    PAGE_LOAD_SYNCHRONOUS,
+    PAGE_LOAD_DEFERRED,
+};
+
+// Source whose atlas is being parsed on this thread, so page loads can pick
+// up its prefetched textures.
+static thread_local const SpineRuntime::SkeletonSource *parsing_source = NULL;
+
+struct SpineCachedAtlas {
+    void *atlas;
+    int refs;
+};
+static Mutex atlas_cache_mutex;
+// keyed by "<runtime version>:<atlas path>"
+static HashMap<String, SpineCachedAtlas> atlas_cache;
+static HashMap<uint64_t, String> atlas_cache_keys;
+
+// Cooked skeletons, see SpineRuntime::save_cooked(). Format 1 files, which
+// carry no atlas table, and format 3 ones, which carry no flags, are still
+// read; format 2 was a section table layout that is rejected.
+#define SPINE_COOKED_MAGIC "SPCK"
+#define SPINE_COOKED_FORMAT_VERSION 4
+#define SPINE_COOKED_MERGED_PAGES 1
+
+
+// Reads the whole file and appends a terminating zero for the json parsers.
+static Error spine_read_file(const String &p_path, Vector<uint8_t> &r_data) {
+    Error err;
+    FileAccess *file = FileAccess::open(p_path, FileAccess::READ, &err);
+    if (file == NULL) {
+        return err;
+    }
+    int len = file->get_len();
+    r_data.resize(len + 1);
+    file->get_buffer(r_data.ptrw(), len);
+    r_data.write[len] = 0;
+    file->close();
+    memdelete(file);
+    return OK;
+}
+
+// Returns the value of the "spine" key inside the top-level "skeleton"
+// object, or an empty string when it isn't within the probe limit.
+static String spine_probe_json_version(const Vector<uint8_t> &p_data) {
+    const uint8_t *data = p_data.ptr();
+    int len = MIN(p_data.size() - 1, SPINE_VERSION_PROBE_LIMIT);
+    int depth = 0;
+    bool in_skeleton = false;
+    bool expect_value = false;
+    String key;
+    for (int i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if (c == '{' || c == '[') {
+            if (depth == 1 && c == '{' && key == "skeleton") {
+                in_skeleton = true;
+            }
+            depth++;
+            expect_value = false;
+        } else if (c == '}' || c == ']') {
+            depth--;
+            if (in_skeleton && depth == 1) {
+                break;
+            }
+        } else if (c == ':') {
+            expect_value = true;
+        } else if (c == ',') {
+            expect_value = false;
+        } else if (c == '"') {
+            int begin = ++i;
+            while (i < len && data[i] != '"') {
+                i += data[i] == '\\' ? 2 : 1;
+            }
+            if (i >= len) {
+                break;
+            }
+            String token = String::utf8((const char *)data + begin, i - begin);
+            if (!expect_value) {
+                key = token;
+            } else if (in_skeleton && depth == 2 && key == "spine") {
+                return token;
+            }
         }
-        String json_content = file->get_as_utf8_string().replace(" ", "").replace("\n", "");
-        file->close();
-        memdelete(file);
+    }
+    return String();
+}
+
+// Drops whitespace outside of strings; keeps the terminating zero.
+static void spine_minify_json(Vector<uint8_t> &r_data) {
+    uint8_t *data = r_data.ptrw();
+    int len = r_data.size() - 1;
+    int out = 0;
+    bool in_string = false;
+    for (int i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if (in_string) {
+            data[out++] = c;
+            if (c == '\\' && i + 1 < len) {
+                data[out++] = data[++i];
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+            data[out++] = c;
+        } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            data[out++] = c;
+        }
+    }
+    data[out] = 0;
+    r_data.resize(out + 1);
+}
+
+// .spjson is a json export renamed so the importer can tell it from other json.
+bool SpineRuntime::is_json(const String &p_path) {
+    String ext = p_path.get_extension().to_lower();
+    return ext == "json" || ext == "spjson";
+}
+
+// Returns the runtime version ("4_1") a json or skel export was made with.
+String SpineRuntime::probe_version(const String &p_path, const Vector<uint8_t> &p_data) {
+    String version;
+    if (is_json(p_path)) {
+        version = spine_probe_json_version(p_data);
+    } else if (p_path.ends_with(".skel") && p_data.size() > 32) {
+        const uint8_t *header = p_data.ptr();
+        if (header[29] == '3' && header[30] == '.') {
+            version = String::chr(header[29]) + "." + String::chr(header[31]);
+        } else if (header[9] == '4' && header[10] == '.') {
+            version = String::chr(header[9]) + "." + String::chr(header[11]);
+        }
+    }
+    return version.substr(0, 3).replace(".", "_");
+}
+
+// <name>.atlas next to the skeleton, or else the atlas named after the
+// skeleton's folder, which lets several skeletons share one atlas
+// (equipment/sword.json and equipment/shield.json use equipment/equipment.atlas).
+String SpineRuntime::find_atlas_path(const String &p_skeleton_path) {
+    String path = p_skeleton_path.get_basename() + ".atlas";
+    if (FileAccess::exists(path)) {
+        return path;
+    }
+    String dir = p_skeleton_path.get_base_dir();
+    String shared = dir.plus_file(dir.get_file() + ".atlas");
+    return FileAccess::exists(shared) ? shared : path;
+}
+
+// Atlas contents for a source read while the atlas was cached but which
+// missed the cache at parse time.
+Vector<uint8_t> SpineRuntime::get_atlas_data(const SkeletonSource &p_source) {
+    Vector<uint8_t> data = p_source.atlas_data;
+    if (data.empty()) {
+        spine_read_file(p_source.atlas_path, data);
+    }
+    return data;
+}
+
+// Page file paths of an atlas. A page name is the first non-empty line of
+// the file and every first line after a blank one; only those lines are
+// decoded.
+Vector<String> SpineRuntime::get_atlas_pages(const String &p_atlas_path, const Vector<uint8_t> &p_atlas_data) {
+    Vector<String> pages;
+    String dir = p_atlas_path.get_base_dir();
+    const char *data = (const char *)p_atlas_data.ptr();
+    int len = p_atlas_data.size() - 1;
+    bool page_next = true;
+    int line_begin = 0;
+    for (int i = 0; i <= len; i++) {
+        if (i < len && data[i] != '\n') {
+            continue;
+        }
+        String line = String::utf8(data + line_begin, i - line_begin).strip_edges();
+        line_begin = i + 1;
+        if (line.empty()) {
+            page_next = true;
+        } else if (page_next) {
+            pages.push_back(dir.plus_file(line).simplify_path());
+            page_next = false;
+        }
+    }
+    return pages;
+}
+
+static Vector<float> spine_variant_scales() {
+    Vector<float> scales;
+    Vector<String> items = String(GLOBAL_GET("spine/textures/atlas_variants")).split(",", false);
+    for (int i = 0; i < items.size(); i++) {
+        float scale = items[i].strip_edges().to_float();
+        if (scale > 0 && scale != 1) {
+            scales.push_back(scale);
+        }
+    }
+    return scales;
+}
+
+// Every page of <atlas>@<scale>x.atlas becomes a resolution variant of the
+// page at the same position in the atlas file. A cooked atlas with merged
+// pages only keeps variants for the pages it didn't merge.
+static void spine_find_page_variants(SpineRuntime::SkeletonSource &r_source) {
+    Vector<float> scales = spine_variant_scales();
+    if (scales.empty()) {
+        return;
+    }
+    Vector<String> pages = SpineRuntime::get_atlas_pages(r_source.atlas_path, r_source.atlas_data);
+    Vector<String> layout = pages;
+    for (int i = 0; i < scales.size(); i++) {
+        String path = r_source.atlas_path.get_basename() + "@" + String::num(scales[i]) + "x.atlas";
+        Vector<uint8_t> data;
+        if (!FileAccess::exists(path) || spine_read_file(path, data) != OK) {
+            continue;
+        }
+        Vector<String> variant_pages = SpineRuntime::get_atlas_pages(path, data);
+        if (variant_pages.size() != layout.size() && layout.size() == pages.size()) {
+            Vector<uint8_t> atlas_file;
+            if (spine_read_file(r_source.atlas_path, atlas_file) == OK) {
+                layout = SpineRuntime::get_atlas_pages(r_source.atlas_path, atlas_file);
+            }
+        }
+        ERR_CONTINUE_MSG(variant_pages.size() != layout.size(), "Spine atlas variant has a different page count: " + path);
+        for (int j = 0; j < layout.size(); j++) {
+            if (pages.find(layout[j]) == -1) {
+                continue;
+            }
+            if (!r_source.page_variants.has(layout[j])) {
+                SpinePage::Variant page = { layout[j], 1.0 };
+                r_source.page_variants[layout[j]].push_back(page);
+            }
+            SpinePage::Variant variant = { variant_pages[j], scales[i] };
+            r_source.page_variants[layout[j]].push_back(variant);
+        }
+    }
+    const String *key = NULL;
+    while ((key = r_source.page_variants.next(key))) {
+        r_source.page_variants[*key].sort();
+    }
+}
+
+bool SpineRuntime::has_atlas(const String &p_version, const String &p_path) {
+    MutexLock lock(atlas_cache_mutex);
+    return atlas_cache.has(p_version + ":" + p_path);
+}
+
+void *SpineRuntime::find_atlas(const String &p_version, const String &p_path) {
+    MutexLock lock(atlas_cache_mutex);
+    SpineCachedAtlas *cached = atlas_cache.getptr(p_version + ":" + p_path);
+    if (!cached) {
+        return NULL;
+    }
+    cached->refs++;
+    load_shared_atlases.increment();
+    return cached->atlas;
+}
+
+void *SpineRuntime::share_atlas(const String &p_version, const String &p_path, void *p_atlas) {
+    MutexLock lock(atlas_cache_mutex);
+    String key = p_version + ":" + p_path;
+    SpineCachedAtlas *cached = atlas_cache.getptr(key);
+    if (cached) {
+        cached->refs++;
+        load_shared_atlases.increment();
+        return cached->atlas;
+    }
+    SpineCachedAtlas entry = { p_atlas, 1 };
+    atlas_cache.set(key, entry);
+    atlas_cache_keys.set((uint64_t)p_atlas, key);
+    return p_atlas;
+}
+
+bool SpineRuntime::release_atlas(void *p_atlas) {
+    MutexLock lock(atlas_cache_mutex);
+    const String *key = atlas_cache_keys.getptr((uint64_t)p_atlas);
+    if (!key) {
+        return true;
+    }
+    String cache_key = *key;
+    SpineCachedAtlas *cached = atlas_cache.getptr(cache_key);
+    if (--cached->refs > 0) {
+        return false;
+    }
+    atlas_cache.erase(cache_key);
+    atlas_cache_keys.erase((uint64_t)p_atlas);
+    return true;
+}
+
+// Reads a json/skel export with its atlas, or a cooked skeleton, so each
+// file is read exactly once.
+Error SpineRuntime::read_skeleton(const String &p_path, SkeletonSource &r_source) {
+    uint64_t begin = OS::get_singleton()->get_ticks_usec();
+    if (p_path.ends_with(".spinec")) {
+        Error err = read_cooked(p_path, r_source);
+        if (err != OK) {
+            return err;
+        }
+    } else {
+        r_source.path = p_path;
+        Error err = spine_read_file(p_path, r_source.data);
+        ERR_FAIL_COND_V_MSG(err != OK, err, "Can't open spine skeleton: " + p_path);
+        r_source.version = probe_version(p_path, r_source.data);
+        r_source.atlas_path = find_atlas_path(p_path);
+        if (!has_atlas(r_source.version, r_source.atlas_path)) {
+            err = spine_read_file(r_source.atlas_path, r_source.atlas_data);
+            ERR_FAIL_COND_V_MSG(err != OK, err, "Can't open spine atlas: " + r_source.atlas_path);
+        }
+    }
+    if (!r_source.atlas_data.empty() && !r_source.merged_pages) {
+        spine_find_page_variants(r_source);
+    }
+    r_source.read_usec = OS::get_singleton()->get_ticks_usec() - begin;
+    return OK;
+}
+
+// Hands the buffers to the runtime matching the source version. Safe to
+// call off the main thread.
+Ref<SpineResource> SpineRuntime::parse_skeleton(const SkeletonSource &p_source) {
+    Ref<SpineResource> res;
+    uint64_t begin = OS::get_singleton()->get_ticks_usec();
+    SpineAllocator::MeasureScope memory;
+    parsing_source = &p_source;
 #ifdef SPINE_RUNTIME_3_6_ENABLED
-        if (json_content.find("\"spine\":\"3.6") >= 0) {
-            res = SpineRuntime_3_6::load_resource(p_path);
-        } else
+    if (p_source.version == "3_6") {
+        res = SpineRuntime_3_6::load_resource(p_source);
+    } else
 #endif
 #ifdef SPINE_RUNTIME_3_7_ENABLED
-        if (json_content.find("\"spine\":\"3.7") >= 0) {
-            res = SpineRuntime_3_7::load_resource(p_path);
-        } else
+    if (p_source.version == "3_7") {
+        res = SpineRuntime_3_7::load_resource(p_source);
+    } else
 #endif
 #ifdef SPINE_RUNTIME_3_8_ENABLED
-        if (json_content.find("\"spine\":\"3.8") >= 0) {
-            res = SpineRuntime_3_8::load_resource(p_path);
-        } else
+    if (p_source.version == "3_8") {
+        res = SpineRuntime_3_8::load_resource(p_source);
+    } else
 #endif
 #ifdef SPINE_RUNTIME_4_0_ENABLED
-        if (json_content.find("\"spine\":\"4.0") >= 0) {
-            res = SpineRuntime_4_0::load_resource(p_path);
-        } else
+    if (p_source.version == "4_0") {
+        res = SpineRuntime_4_0::load_resource(p_source);
+    } else
 #endif
 #ifdef SPINE_RUNTIME_4_1_ENABLED
-        if (json_content.find("\"spine\":\"4.1") >= 0) {
-            res = SpineRuntime_4_1::load_resource(p_path);
-        } else
+    if (p_source.version == "4_1") {
+        res = SpineRuntime_4_1::load_resource(p_source);
+    } else
 #endif
-        {
-            ERR_FAIL_V_MSG(res, "No suitable spine runtime found");
+    {
+        ERR_PRINT("No suitable spine runtime found for version \"" + p_source.version + "\": " + p_source.path);
+    }
+    parsing_source = NULL;
+    if (res.is_valid()) {
+        res->load_bytes = p_source.data.size() - 1 + MAX(p_source.atlas_data.size() - 1, 0);
+        res->load_read_usec = p_source.read_usec;
+        res->load_parse_usec = OS::get_singleton()->get_ticks_usec() - begin;
+        res->load_memory = memory.get_bytes();
+        res->queued_pages = p_source.queued_pages;
+        load_count.increment();
+        load_bytes.add(res->load_bytes);
+        load_read_usec.add(res->load_read_usec);
+        load_parse_usec.add(res->load_parse_usec);
+        load_memory.add(res->load_memory);
+    }
+    return res;
+}
+
+Dictionary SpineRuntime::get_load_report() {
+    Dictionary report;
+    report["skeletons"] = load_count.get();
+    report["bytes"] = load_bytes.get();
+    report["read_usec"] = load_read_usec.get();
+    report["parse_usec"] = load_parse_usec.get();
+    report["memory"] = load_memory.get();
+    report["shared_atlases"] = load_shared_atlases.get();
+    {
+        MutexLock lock(atlas_cache_mutex);
+        report["cached_atlases"] = atlas_cache.size();
+    }
+    return report;
+}
+
+void SpineRuntime::reset_load_report() {
+    load_count.set(0);
+    load_bytes.set(0);
+    load_read_usec.set(0);
+    load_parse_usec.set(0);
+    load_memory.set(0);
+    load_shared_atlases.set(0);
+}
+
+// Gap kept between packed images so filtering never samples a neighbour.
+#define SPINE_PACK_PADDING 2
+
+// Shelf packing: images come sorted by height, so every shelf is as high
+// as its first image.
+struct SpineShelf {
+    int width;
+    int height;
+    int shelf_x;
+    int shelf_y;
+    int shelf_height;
+    int count;
+
+    SpineShelf() { width = height = shelf_x = shelf_y = shelf_height = count = 0; }
+};
+
+static bool spine_shelf_place(SpineShelf &r_shelf, const Ref<Image> &p_image, int p_max_size, Point2 &r_position) {
+    int limit = p_max_size + SPINE_PACK_PADDING;
+    int w = p_image->get_width() + SPINE_PACK_PADDING;
+    int h = p_image->get_height() + SPINE_PACK_PADDING;
+    if (r_shelf.shelf_x + w > limit) {
+        r_shelf.shelf_y += r_shelf.shelf_height;
+        r_shelf.shelf_x = 0;
+        r_shelf.shelf_height = 0;
+    }
+    if (r_shelf.shelf_x + w > limit || r_shelf.shelf_y + h > limit) {
+        return false;
+    }
+    r_position = Point2(r_shelf.shelf_x, r_shelf.shelf_y);
+    r_shelf.shelf_x += w;
+    r_shelf.shelf_height = MAX(r_shelf.shelf_height, h);
+    r_shelf.width = MAX(r_shelf.width, r_shelf.shelf_x - SPINE_PACK_PADDING);
+    r_shelf.height = MAX(r_shelf.height, r_shelf.shelf_y + h - SPINE_PACK_PADDING);
+    r_shelf.count++;
+    return true;
+}
+
+static void spine_shelf_blit(Ref<Image> &r_target, Ref<Image> p_image, const Point2 &p_position) {
+    if (p_image->is_compressed()) {
+        p_image->decompress();
+    }
+    p_image->convert(Image::FORMAT_RGBA8);
+    r_target->blit_rect(p_image, Rect2(Point2(), p_image->get_size()), p_position);
+}
+
+struct SpineImageHeight {
+    const Vector<Ref<Image> > *images;
+
+    _FORCE_INLINE_ bool operator()(int p_a, int p_b) const {
+        return (*images)[p_a]->get_height() > (*images)[p_b]->get_height();
+    }
+};
+
+Ref<Image> SpineRuntime::pack_images(const Vector<Ref<Image> > &p_images, int p_max_size, Vector<Point2> &r_positions) {
+    Vector<int> order;
+    for (int i = 0; i < p_images.size(); i++) {
+        order.push_back(i);
+    }
+    SortArray<int, SpineImageHeight> sorter;
+    sorter.compare.images = &p_images;
+    sorter.sort(order.ptrw(), order.size());
+    SpineShelf shelf;
+    r_positions.resize(p_images.size());
+    for (int i = 0; i < order.size(); i++) {
+        if (!spine_shelf_place(shelf, p_images[order[i]], p_max_size, r_positions.write[order[i]])) {
+            return Ref<Image>();
         }
-    } else if (p_path.ends_with(".skel")) {
-        FileAccess* file = FileAccess::open(p_path, FileAccess::READ);
-        if (file == NULL) {
-            return res;
+    }
+    Ref<Image> image;
+    image.instance();
+    image->create(MAX(shelf.width, 1), MAX(shelf.height, 1), false, Image::FORMAT_RGBA8);
+    for (int i = 0; i < p_images.size(); i++) {
+        spine_shelf_blit(image, p_images[i], r_positions[i]);
+    }
+    return image;
+}
+
+// One page of an atlas text while merging, see merge_atlas_pages().
+struct SpineMergePage {
+    String name;
+    // key:value lines of the page, and the same without size and blanks,
+    // which pages must share to be merged
+    Vector<String> header;
+    String signature;
+    bool mergeable;
+    // region names followed by their key:value lines
+    Vector<String> regions;
+    Ref<Image> image;
+    int bin;
+    Point2 position;
+};
+
+struct SpineMergeBin {
+    String signature;
+    SpineShelf shelf;
+    String name;
+};
+
+struct SpineMergePageHeight {
+    _FORCE_INLINE_ bool operator()(const SpineMergePage *p_a, const SpineMergePage *p_b) const {
+        return p_a->image->get_height() > p_b->image->get_height();
+    }
+};
+
+// Moves an "xy" (3.x) or "bounds" (4.x) region line by the page offset.
+static String spine_merge_region_line(const String &p_line, int p_x, int p_y) {
+    String key = p_line.get_slice(":", 0).strip_edges();
+    if (p_line.find(":") == -1 || (key != "xy" && key != "bounds")) {
+        return p_line;
+    }
+    Vector<String> values = p_line.get_slice(":", 1).split(",");
+    ERR_FAIL_COND_V(values.size() < 2, p_line);
+    String line = p_line.substr(0, p_line.find(":") + 1) + (p_line.find(": ") != -1 ? " " : "");
+    line += itos(values[0].strip_edges().to_int() + p_x) + "," + (key == "xy" ? " " : "") + itos(values[1].strip_edges().to_int() + p_y);
+    for (int i = 2; i < values.size(); i++) {
+        line += "," + values[i].strip_edges();
+    }
+    return line;
+}
+
+// Repacks atlas pages that share format, filter and alpha settings into as
+// few pages of at most p_max_size pixels as possible, saved as
+// <p_page_base><n>.png and added to r_files. r_source gets the rewritten
+// atlas text, with region positions moved onto the merged pages, which it
+// names relative to the atlas; the atlas path is kept, so the result is
+// meant for cooking, and is cached apart from the unmerged atlas, see
+// SkeletonSource::get_atlas_key(). Pages that repeat, are larger than
+// p_max_size or can't be decoded are kept as they are.
+Error SpineRuntime::merge_atlas_pages(SkeletonSource &r_source, int p_max_size, const String &p_page_base, List<String> *r_files) {
+    Vector<uint8_t> data = get_atlas_data(r_source);
+    ERR_FAIL_COND_V_MSG(data.empty(), ERR_FILE_CANT_OPEN, "Can't open spine atlas: " + r_source.atlas_path);
+    String text;
+    text.parse_utf8((const char *)data.ptr(), data.size() - 1);
+    Vector<String> lines = text.split("\n");
+    String dir = r_source.atlas_path.get_base_dir();
+
+    Vector<SpineMergePage> pages;
+    bool page_next = true;
+    bool in_header = false;
+    for (int i = 0; i < lines.size(); i++) {
+        String line = lines[i].strip_edges(false, true);
+        if (line.strip_edges().empty()) {
+            page_next = true;
+        } else if (page_next) {
+            SpineMergePage page;
+            page.name = line.strip_edges();
+            page.mergeable = true;
+            page.bin = -1;
+            pages.push_back(page);
+            page_next = false;
+            in_header = true;
+        } else if (in_header && line.find(":") != -1) {
+            SpineMergePage &page = pages.write[pages.size() - 1];
+            page.header.push_back(line);
+            String key = line.get_slice(":", 0).strip_edges();
+            if (key == "repeat") {
+                page.mergeable = line.get_slice(":", 1).strip_edges() == "none";
+            } else if (key != "size") {
+                page.signature += line.replace(" ", "").replace("\t", "") + ";";
+            }
+        } else {
+            in_header = false;
+            pages.write[pages.size() - 1].regions.push_back(line);
+        }
+    }
+
+    Vector<SpineMergePage *> order;
+    for (int i = 0; i < pages.size(); i++) {
+        SpineMergePage *page = pages.ptrw() + i;
+        if (!page->mergeable) {
+            continue;
+        }
+        page->image.instance();
+        if (page->image->load(dir.plus_file(page->name)) != OK) {
+            page->image = Ref<Image>();
+            continue;
+        }
+        if (page->image->get_width() <= p_max_size && page->image->get_height() <= p_max_size) {
+            order.push_back(page);
+        }
+    }
+    order.sort_custom<SpineMergePageHeight>();
+    Vector<SpineMergeBin> bins;
+    for (int i = 0; i < order.size(); i++) {
+        SpineMergePage *page = order[i];
+        for (int j = 0; j < bins.size() && page->bin < 0; j++) {
+            if (bins[j].signature == page->signature && spine_shelf_place(bins.write[j].shelf, page->image, p_max_size, page->position)) {
+                page->bin = j;
+            }
+        }
+        if (page->bin < 0) {
+            SpineMergeBin bin;
+            bin.signature = page->signature;
+            spine_shelf_place(bin.shelf, page->image, p_max_size, page->position);
+            page->bin = bins.size();
+            bins.push_back(bin);
+        }
+    }
+
+    int merged = 0;
+    for (int i = 0; i < bins.size(); i++) {
+        SpineMergeBin &bin = bins.write[i];
+        if (bin.shelf.count < 2) {
+            continue;
+        }
+        String path = p_page_base + itos(merged++) + ".png";
+        bin.name = r_source.atlas_path.path_to_file(path);
+        Ref<Image> image;
+        image.instance();
+        image->create(bin.shelf.width, bin.shelf.height, false, Image::FORMAT_RGBA8);
+        for (int j = 0; j < order.size(); j++) {
+            if (order[j]->bin == i) {
+                spine_shelf_blit(image, order[j]->image, order[j]->position);
+            }
+        }
+        Error err = image->save_png(path);
+        ERR_FAIL_COND_V_MSG(err != OK, err, "Can't write merged spine atlas page: " + path);
+        if (r_files) {
+            r_files->push_back(path);
+        }
+    }
+    if (merged == 0) {
+        return OK;
+    }
+
+    // every merged page takes the place of its first source page
+    String out;
+    for (int i = 0; i < pages.size(); i++) {
+        const SpineMergePage &page = pages[i];
+        if (page.bin >= 0 && bins[page.bin].shelf.count >= 2) {
+            const SpineMergeBin &bin = bins[page.bin];
+            if (bin.name.empty()) continue;
+            out += "\n" + bin.name + "\n";
+            for (int j = 0; j < page.header.size(); j++) {
+                const String &line = page.header[j];
+                if (line.get_slice(":", 0).strip_edges() == "size") {
+                    out += line.substr(0, line.find(":") + 1) + (line.find(": ") != -1 ? " " : "") + itos(bin.shelf.width) + "," + itos(bin.shelf.height) + "\n";
+                } else {
+                    out += line + "\n";
+                }
+            }
+            for (int j = i; j < pages.size(); j++) {
+                if (pages[j].bin != page.bin) continue;
+                for (int k = 0; k < pages[j].regions.size(); k++) {
+                    out += spine_merge_region_line(pages[j].regions[k], pages[j].position.x, pages[j].position.y) + "\n";
+                }
+            }
+            bins.write[page.bin].name = String();
+        } else {
+            out += "\n" + page.name + "\n";
+            for (int j = 0; j < page.header.size(); j++) {
+                out += page.header[j] + "\n";
+            }
+            for (int j = 0; j < page.regions.size(); j++) {
+                out += page.regions[j] + "\n";
+            }
+        }
+    }
+    CharString utf8 = out.utf8();
+    r_source.atlas_data.resize(utf8.length() + 1);
+    memcpy(r_source.atlas_data.ptrw(), utf8.get_data(), utf8.length() + 1);
+    // variants share the original page layout, merged pages have none
+    r_source.page_variants.clear();
+    r_source.merged_pages = true;
+    return OK;
+}
+
+static void spine_put_32(Vector<uint8_t> &r_data, uint32_t p_value) {
+    int ofs = r_data.size();
+    r_data.resize(ofs + 4);
+    encode_uint32(p_value, r_data.ptrw() + ofs);
+}
+
+static void spine_put_float(Vector<uint8_t> &r_data, float p_value) {
+    int ofs = r_data.size();
+    r_data.resize(ofs + 4);
+    encode_float(p_value, r_data.ptrw() + ofs);
+}
+
+static void spine_put_string(Vector<uint8_t> &r_data, const String &p_value) {
+    CharString utf8 = p_value.utf8();
+    spine_put_32(r_data, utf8.length());
+    int ofs = r_data.size();
+    r_data.resize(ofs + utf8.length());
+    memcpy(r_data.ptrw() + ofs, utf8.get_data(), utf8.length());
+}
+
+static void spine_put_ints(Vector<uint8_t> &r_data, const Vector<int> &p_values) {
+    spine_put_32(r_data, p_values.size());
+    for (int i = 0; i < p_values.size(); i++) {
+        spine_put_32(r_data, p_values[i]);
+    }
+}
+
+// Bounds checked reads of an encoded SpineAtlasTable; past the end every
+// read returns 0 and sets failed.
+struct SpineTableReader {
+    const Vector<uint8_t> &data;
+    int ofs;
+    bool failed;
+
+    bool has(uint32_t p_bytes) {
+        failed = failed || (uint64_t)ofs + p_bytes > (uint64_t)data.size();
+        return !failed;
+    }
+    uint32_t get_32() {
+        if (!has(4)) return 0;
+        uint32_t value = decode_uint32(data.ptr() + ofs);
+        ofs += 4;
+        return value;
+    }
+    float get_float() {
+        if (!has(4)) return 0;
+        float value = decode_float(data.ptr() + ofs);
+        ofs += 4;
+        return value;
+    }
+    String get_string() {
+        uint32_t length = get_32();
+        if (!has(length)) return String();
+        String value = String::utf8((const char *)data.ptr() + ofs, length);
+        ofs += length;
+        return value;
+    }
+    Vector<int> get_ints() {
+        Vector<int> values;
+        uint32_t count = get_32();
+        if (!has(count * 4)) return values;
+        values.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            values.write[i] = get_32();
         }
-        uint8_t header[32];
-        file->get_buffer(header, 32);
-        file->close();
+        return values;
+    }
+
+    SpineTableReader(const Vector<uint8_t> &p_data) :
+            data(p_data), ofs(0), failed(false) {}
+};
+
+Vector<uint8_t> SpineAtlasTable::encode() const {
+    Vector<uint8_t> data;
+    spine_put_32(data, pages.size());
+    for (int i = 0; i < pages.size(); i++) {
+        const Page &page = pages[i];
+        spine_put_string(data, page.name);
+        spine_put_32(data, page.format);
+        spine_put_32(data, page.min_filter);
+        spine_put_32(data, page.mag_filter);
+        spine_put_32(data, page.u_wrap);
+        spine_put_32(data, page.v_wrap);
+        spine_put_32(data, page.width);
+        spine_put_32(data, page.height);
+        spine_put_32(data, page.pma);
+    }
+    spine_put_32(data, regions.size());
+    for (int i = 0; i < regions.size(); i++) {
+        const Region &region = regions[i];
+        spine_put_32(data, region.page);
+        spine_put_string(data, region.name);
+        spine_put_32(data, region.x);
+        spine_put_32(data, region.y);
+        spine_put_32(data, region.width);
+        spine_put_32(data, region.height);
+        spine_put_float(data, region.u);
+        spine_put_float(data, region.v);
+        spine_put_float(data, region.u2);
+        spine_put_float(data, region.v2);
+        spine_put_float(data, region.offset_x);
+        spine_put_float(data, region.offset_y);
+        spine_put_32(data, region.original_width);
+        spine_put_32(data, region.original_height);
+        spine_put_32(data, region.index);
+        spine_put_32(data, region.degrees);
+        spine_put_ints(data, region.splits);
+        spine_put_ints(data, region.pads);
+    }
+    return data;
+}
+
+Error SpineAtlasTable::decode(const Vector<uint8_t> &p_data) {
+    SpineTableReader reader(p_data);
+    pages.resize(reader.get_32());
+    for (int i = 0; i < pages.size() && !reader.failed; i++) {
+        Page &page = pages.write[i];
+        page.name = reader.get_string();
+        page.format = reader.get_32();
+        page.min_filter = reader.get_32();
+        page.mag_filter = reader.get_32();
+        page.u_wrap = reader.get_32();
+        page.v_wrap = reader.get_32();
+        page.width = reader.get_32();
+        page.height = reader.get_32();
+        page.pma = reader.get_32();
+    }
+    regions.resize(reader.failed ? 0 : reader.get_32());
+    for (int i = 0; i < regions.size() && !reader.failed; i++) {
+        Region &region = regions.write[i];
+        region.page = reader.get_32();
+        region.name = reader.get_string();
+        region.x = reader.get_32();
+        region.y = reader.get_32();
+        region.width = reader.get_32();
+        region.height = reader.get_32();
+        region.u = reader.get_float();
+        region.v = reader.get_float();
+        region.u2 = reader.get_float();
+        region.v2 = reader.get_float();
+        region.offset_x = reader.get_float();
+        region.offset_y = reader.get_float();
+        region.original_width = reader.get_32();
+        region.original_height = reader.get_32();
+        region.index = reader.get_32();
+        region.degrees = reader.get_32();
+        region.splits = reader.get_ints();
+        region.pads = reader.get_ints();
+        reader.failed = reader.failed || region.page < 0 || region.page >= pages.size();
+    }
+    if (reader.failed) {
+        pages.clear();
+        regions.clear();
+        return ERR_FILE_CORRUPT;
+    }
+    return OK;
+}
+
+Vector<uint8_t> SpineRuntime::cook_atlas(const SkeletonSource &p_source) {
+    const String &runtime_version = p_source.version;
+    SPINE_RESOURCE_DISPATCH(return, cook_atlas(p_source))
+    {
+        return Vector<uint8_t>();
+    }
+}
+
+// Cooked skeletons hold a header naming the runtime version and source
+// path, then the atlas text, the skeleton data and the atlas table, each
+// prefixed with its size. Runtimes that support it build the atlas from
+// the table instead of parsing the text, which stays for page lookups;
+// the skeleton itself is still parsed:
+//   "SPCK", u32 format version, pascal runtime version, pascal source path,
+//   u32 atlas size, atlas, u32 skeleton size, skeleton,
+//   u32 table size, table (format 3),
+//   u32 flags (format 4; SPINE_COOKED_MERGED_PAGES)
+// Mapping the file and referencing its data in place is out of scope: the
+// spine runtimes copy everything into their own containers while parsing,
+// and FileAccess has no mmap.
+Error SpineRuntime::save_cooked(const String &p_path, const SkeletonSource &p_source) {
+    Error err;
+    FileAccess *file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+    ERR_FAIL_COND_V_MSG(file == NULL, err, "Can't write cooked spine skeleton: " + p_path);
+    Vector<uint8_t> data = p_source.data;
+    if (is_json(p_source.path)) {
+        spine_minify_json(data);
+    }
+    Vector<uint8_t> atlas_data = get_atlas_data(p_source);
+    if (atlas_data.empty()) {
+        memdelete(file);
+        ERR_FAIL_V_MSG(ERR_FILE_CANT_OPEN, "Can't open spine atlas: " + p_source.atlas_path);
+    }
+    Vector<uint8_t> atlas_table = cook_atlas(p_source);
+    file->store_buffer((const uint8_t *)SPINE_COOKED_MAGIC, 4);
+    file->store_32(SPINE_COOKED_FORMAT_VERSION);
+    file->store_pascal_string(p_source.version);
+    file->store_pascal_string(p_source.path);
+    file->store_32(atlas_data.size() - 1);
+    file->store_buffer(atlas_data.ptr(), atlas_data.size() - 1);
+    file->store_32(data.size() - 1);
+    file->store_buffer(data.ptr(), data.size() - 1);
+    file->store_32(atlas_table.size());
+    file->store_buffer(atlas_table.ptr(), atlas_table.size());
+    file->store_32(p_source.merged_pages ? SPINE_COOKED_MERGED_PAGES : 0);
+    err = file->get_error();
+    file->close();
+    memdelete(file);
+    return err;
+}
+
+Error SpineRuntime::read_cooked(const String &p_path, SkeletonSource &r_source) {
+    Error err;
+    FileAccess *file = FileAccess::open(p_path, FileAccess::READ, &err);
+    ERR_FAIL_COND_V_MSG(file == NULL, err, "Can't open cooked spine skeleton: " + p_path);
+    uint8_t magic[4];
+    file->get_buffer(magic, 4);
+    uint32_t format = memcmp(magic, SPINE_COOKED_MAGIC, 4) == 0 ? file->get_32() : 0;
+    if (format != 1 && format != 3 && format != SPINE_COOKED_FORMAT_VERSION) {
         memdelete(file);
+        ERR_FAIL_V_MSG(ERR_FILE_UNRECOGNIZED, "Unsupported cooked spine skeleton, reimport it: " + p_path);
+    }
+    r_source.version = file->get_pascal_string();
+    r_source.path = file->get_pascal_string();
+    Vector<uint8_t> *targets[] = { &r_source.atlas_data, &r_source.data, &r_source.atlas_table };
+    for (int i = 0; i < (format == 1 ? 2 : 3); i++) {
+        uint32_t size = file->get_32();
+        if (file->eof_reached() || file->get_position() + size > file->get_len()) {
+            break;
+        }
+        // the table is binary and goes without the terminating zero
+        int terminator = targets[i] == &r_source.atlas_table ? 0 : 1;
+        targets[i]->resize(size + terminator);
+        file->get_buffer(targets[i]->ptrw(), size);
+        if (terminator) {
+            targets[i]->write[size] = 0;
+        }
+    }
+    if (format >= 4) {
+        r_source.merged_pages = file->get_32() & SPINE_COOKED_MERGED_PAGES;
+    }
+    file->close();
+    memdelete(file);
+    r_source.atlas_path = find_atlas_path(r_source.path);
+    ERR_FAIL_COND_V_MSG(r_source.data.empty() || r_source.atlas_data.empty(), ERR_FILE_CORRUPT, "Truncated cooked spine skeleton: " + p_path);
+    return OK;
+}
 
-#ifdef SPINE_RUNTIME_3_6_ENABLED
-        if (header[29] == '3' && header[30] == '.' && header[31] == '6') {
-            res = SpineRuntime_3_6::load_resource(p_path);
-        } else
-#endif
-#ifdef SPINE_RUNTIME_3_7_ENABLED
-        if (header[29] == '3' && header[30] == '.' && header[31] == '7') {
-            res = SpineRuntime_3_7::load_resource(p_path);
-        } else
-#endif
-#ifdef SPINE_RUNTIME_3_8_ENABLED    
-        if (header[29] == '3' && header[30] == '.' && header[31] == '8') {
-            res = SpineRuntime_3_8::load_resource(p_path);
-        } else
-#endif
-#ifdef SPINE_RUNTIME_4_0_ENABLED    
-        if (header[9] == '4' && header[10] == '.' && header[11] == '0') {
-            res = SpineRuntime_4_0::load_resource(p_path);
-        } else
-#endif
-#ifdef SPINE_RUNTIME_4_1_ENABLED    
-        if (header[9] == '4' && header[10] == '.' && header[11] == '1') {
-            res = SpineRuntime_4_1::load_resource(p_path);
-        } else
-#endif
-        {
-            ERR_FAIL_V_MSG(res, "No suitable spine runtime found");
+int SpineRuntime::get_cooked_format_version() {
+    return SPINE_COOKED_FORMAT_VERSION;
+}
+
+void SpineRuntime::finish_resource(Ref<SpineResource> p_res, const String &p_path) {
+    String mixes_path = p_path.get_basename() + ".mixes";
+    if (p_res.is_valid() && FileAccess::exists(mixes_path)) {
+        p_res->load_mixes(mixes_path);
+    }
+    if (p_res.is_valid()) {
+        p_res->prewarm_runtimes(GLOBAL_GET("spine/pool/prewarm"));
+    }
+}
+
+Ref<SpineResource> SpineRuntime::load_resource(const String &p_path) {
+    SkeletonSource source;
+    if (read_skeleton(p_path, source) != OK) {
+        return Ref<SpineResource>();
+    }
+    prefetch_textures(source);
+    Ref<SpineResource> res = parse_skeleton(source);
+    if (res.is_valid()) {
+        finish_resource(res, source.path);
+        if (Thread::get_caller_id() == Thread::get_main_id()) {
+            res->finalize_textures();
         }
     }
     return res;
 }
 
+// Raw page images are decoded by a few workers shared by every load, one
+// per processor besides the caller, which decodes queued pages as well
+// while it waits for its own.
+struct SpineDecodeBatch {
+    SafeNumeric<uint32_t> remaining;
+    Semaphore done;
+};
+
+// A page decode belongs to a batch waited on by its caller, or else swaps
+// page to the given variant once update_pages() picks it up.
+struct SpinePageDecode {
+    String path;
+    Ref<Image> image;
+    SpineDecodeBatch *batch;
+    // cleared when the page is unloaded first
+    SpinePage *page;
+    int variant;
+
+    SpinePageDecode() {
+        batch = NULL;
+        page = NULL;
+        variant = 0;
+    }
+};
+
+static Mutex decode_mutex;
+static Vector<SpinePageDecode *> decode_queue;
+// finished variant decodes, waiting for update_pages()
+static Vector<SpinePageDecode *> decoded_variants;
+static Semaphore decode_semaphore;
+static Vector<Thread *> decode_threads;
+static SafeFlag decode_exit;
+
+static void spine_decode_page(SpinePageDecode *p_page) {
+    SpineDecodeBatch *batch = p_page->batch;
+    p_page->image.instance();
+    if (p_page->image->load(p_page->path) != OK) {
+        p_page->image = Ref<Image>();
+    }
+    if (!batch) {
+        MutexLock lock(decode_mutex);
+        decoded_variants.push_back(p_page);
+    } else if (batch->remaining.decrement() == 0) {
+        batch->done.post();
+    }
+}
+
+static SpinePageDecode *spine_pop_decode() {
+    MutexLock lock(decode_mutex);
+    if (decode_queue.empty()) {
+        return NULL;
+    }
+    SpinePageDecode *page = decode_queue[0];
+    decode_queue.remove(0);
+    return page;
+}
+
+static void spine_decode_worker(void *p_userdata) {
+    while (true) {
+        decode_semaphore.wait();
+        if (decode_exit.is_set()) {
+            return;
+        }
+        SpinePageDecode *page = spine_pop_decode();
+        if (page) {
+            spine_decode_page(page);
+        }
+    }
+}
+
+static void spine_queue_decodes(const Vector<SpinePageDecode *> &p_pages) {
+    {
+        MutexLock lock(decode_mutex);
+        if (decode_threads.empty()) {
+            int count = MAX(OS::get_singleton()->get_processor_count() - 1, 1);
+            for (int i = 0; i < count; i++) {
+                Thread *thread = memnew(Thread);
+                thread->start(spine_decode_worker, NULL);
+                decode_threads.push_back(thread);
+            }
+        }
+        for (int i = 0; i < p_pages.size(); i++) {
+            decode_queue.push_back(p_pages[i]);
+        }
+    }
+    for (int i = 0; i < p_pages.size(); i++) {
+        decode_semaphore.post();
+    }
+}
+
+// Queues p_pages, which share one batch, and returns once all are decoded.
+static void spine_decode_pages(const Vector<SpinePageDecode *> &p_pages) {
+    if (p_pages.empty()) {
+        return;
+    }
+    SpineDecodeBatch *batch = p_pages[0]->batch;
+    batch->remaining.set(p_pages.size());
+    spine_queue_decodes(p_pages);
+    while (batch->remaining.get() > 0) {
+        SpinePageDecode *page = spine_pop_decode();
+        if (page) {
+            spine_decode_page(page);
+        } else {
+            batch->done.wait();
+        }
+    }
+}
+
+void SpineRuntime::finish() {
+    decode_exit.set();
+    for (int i = 0; i < decode_threads.size(); i++) {
+        decode_semaphore.post();
+    }
+    for (int i = 0; i < decode_threads.size(); i++) {
+        decode_threads[i]->wait_to_finish();
+        memdelete(decode_threads[i]);
+    }
+    decode_threads.clear();
+    // variant swaps still queued or waiting for update_pages()
+    for (int i = 0; i < decoded_variants.size(); i++) {
+        decode_queue.push_back(decoded_variants[i]);
+    }
+    for (int i = 0; i < decode_queue.size(); i++) {
+        if (decode_queue[i]->page) {
+            decode_queue[i]->page->variant_decode = NULL;
+        }
+        memdelete(decode_queue[i]);
+    }
+    decode_queue.clear();
+    decoded_variants.clear();
+}
+
+// Loads the atlas pages before parsing so the atlas loader never calls
+// ResourceLoader mid-parse. Raw images go to the decode workers; imported
+// textures are loaded here on the main thread and left to the pending
+// queue otherwise. Nothing is fetched for atlases that are already cached.
+void SpineRuntime::prefetch_textures(SkeletonSource &r_source) {
+    if (r_source.atlas_data.empty() || GLOBAL_GET("spine/textures/lazy_pages")) {
+        return;
+    }
+    bool main_thread = Thread::get_caller_id() == Thread::get_main_id();
+    Vector<String> paths = get_atlas_pages(r_source.atlas_path, r_source.atlas_data);
+    SpineDecodeBatch batch;
+    Vector<SpinePageDecode *> decoding;
+    for (int i = 0; i < paths.size(); i++) {
+        if (ResourceLoader::exists(paths[i], "Texture")) {
+            if (main_thread) {
+                r_source.textures.set(paths[i], ResourceLoader::load(paths[i], "Texture"));
+            }
+            continue;
+        }
+        SpinePageDecode *page = memnew(SpinePageDecode);
+        page->path = paths[i];
+        page->batch = &batch;
+        decoding.push_back(page);
+    }
+    spine_decode_pages(decoding);
+    for (int i = 0; i < decoding.size(); i++) {
+        if (decoding[i]->image.is_valid()) {
+            r_source.images.set(decoding[i]->path, decoding[i]->image);
+        }
+        memdelete(decoding[i]);
+    }
+}
+
+static CanvasItem *spine_page_drawer(ObjectID p_id) {
+    return Object::cast_to<CanvasItem>(ObjectDB::get_instance(p_id));
+}
+
+// Page textures are counted as uncompressed RGBA8. Items still drawing the
+// old texture are redrawn, paused ones included.
+static void spine_set_page_texture(SpinePage *p_page, const Ref<Texture> &p_texture) {
+    for (Set<ObjectID>::Element *E = p_page->drawn_by.front(); E; E = E->next()) {
+        CanvasItem *item = spine_page_drawer(E->get());
+        if (item && item->is_inside_tree()) {
+            item->update();
+        }
+    }
+    p_page->drawn_by.clear();
+    p_page->last_drawer = 0;
+    p_page->texture = p_texture;
+    p_page->bytes = p_texture.is_valid() ? p_texture->get_width() * p_texture->get_height() * 4 : 0;
+}
+
+// Path of the loaded variant.
+static String spine_page_path(const SpinePage *p_page) {
+    return p_page->variants.empty() ? p_page->path : p_page->variants[p_page->variant].path;
+}
+
+static Ref<Texture> spine_load_page_texture(const String &p_path, const Ref<Image> &p_image) {
+    Ref<Image> image = p_image;
+    if (image.is_null()) {
+        Ref<Texture> texture = ResourceLoader::load(p_path);
+        if (texture.is_valid()) {
+            return texture;
+        }
+        image.instance();
+        if (image->load(p_path) != OK) {
+            ERR_FAIL_V_MSG(Ref<Texture>(), "Can't load spine atlas page: " + p_path);
+        }
+    }
+    Ref<ImageTexture> imgtex = memnew(ImageTexture);
+    imgtex->create_from_image(image);
+    return imgtex;
+}
+
+static SpinePage *spine_new_page(const String &p_path) {
+    SpinePage *page = memnew(SpinePage);
+    page->path = p_path;
+    page->pending = false;
+    page->requested = false;
+    page->used_msec = pages_msec;
+    page->used_frame = pages_frame;
+    page->bytes = 0;
+    page->variant = 0;
+    page->width = 0;
+    page->height = 0;
+    page->draw_scale = 0;
+    page->scale_msec = pages_msec;
+    page->variant_decode = NULL;
+    page->last_drawer = 0;
+    return page;
+}
+
+SpinePage *SpineRuntime::load_page(const String &p_path, int *r_width, int *r_height) {
+    // merged pages live in the import folder and are named relative to the atlas
+    String path = p_path.simplify_path();
+    SpinePage *page = spine_new_page(path);
+    const Vector<SpinePage::Variant> *variants = parsing_source ? parsing_source->page_variants.getptr(path) : NULL;
+    if (variants) {
+        page->variants = *variants;
+        while (page->variants[page->variant].scale != 1) {
+            page->variant++;
+        }
+    }
+    const Ref<Texture> *prefetched = parsing_source ? parsing_source->textures.getptr(path) : NULL;
+    const Ref<Image> *image = parsing_source ? parsing_source->images.getptr(path) : NULL;
+    bool lazy = GLOBAL_GET("spine/textures/lazy_pages");
+    if (prefetched && prefetched->is_valid()) {
+        spine_set_page_texture(page, *prefetched);
+    } else if (lazy) {
+        // loaded on first draw, the atlas keeps its declared page size
+    } else if (Thread::get_caller_id() != Thread::get_main_id()) {
+        // imported textures are only loaded by the main thread, raw images
+        // are decoded here; the atlas keeps its declared page size
+        if (image) {
+            page->image = *image;
+        } else if (!ResourceLoader::exists(path, "Texture")) {
+            page->image.instance();
+            if (page->image->load(path) != OK) {
+                memdelete(page);
+                ERR_FAIL_V_MSG(NULL, "Can't load spine atlas page: " + path);
+            }
+        }
+        page->pending = true;
+    } else {
+        spine_set_page_texture(page, spine_load_page_texture(path, image ? *image : Ref<Image>()));
+        if (page->texture.is_null()) {
+            memdelete(page);
+            return NULL;
+        }
+    }
+    if (page->texture.is_valid()) {
+        *r_width = page->texture->get_width();
+        *r_height = page->texture->get_height();
+    }
+    page->width = *r_width;
+    page->height = *r_height;
+    MutexLock lock(pages_mutex);
+    pages.push_back(page);
+    if (page->pending) {
+        pending_pages.push_back(page);
+        pending_page_count.increment();
+        if (parsing_source) {
+            parsing_source->queued_pages.push_back(page);
+        }
+    }
+    return page;
+}
+
+// Pages made at runtime have no file to load again from, so they are never
+// evicted.
+SpinePage *SpineRuntime::create_page(const Ref<Texture> &p_texture) {
+    ERR_FAIL_COND_V(p_texture.is_null(), NULL);
+    SpinePage *page = spine_new_page(String());
+    spine_set_page_texture(page, p_texture);
+    page->width = p_texture->get_width();
+    page->height = p_texture->get_height();
+    MutexLock lock(pages_mutex);
+    pages.push_back(page);
+    return page;
+}
+
+void SpineRuntime::unload_page(SpinePage *p_page) {
+    {
+        MutexLock lock(decode_mutex);
+        if (p_page->variant_decode) {
+            p_page->variant_decode->page = NULL;
+        }
+    }
+    {
+        MutexLock lock(pages_mutex);
+        pages.erase(p_page);
+        if (p_page->pending) {
+            pending_pages.erase(p_page);
+            pending_page_count.decrement();
+        }
+        requested_pages.erase(p_page);
+    }
+    if (parsing_source) {
+        // the atlas lost a share_atlas() race and is freed mid-parse
+        parsing_source->queued_pages.erase(p_page);
+    }
+    memdelete(p_page);
+}
+
+Ref<Texture> SpineRuntime::get_page_texture(SpinePage *p_page) {
+    if (!p_page) {
+        return Ref<Texture>();
+    }
+    if (Thread::get_caller_id() != Thread::get_main_id()) {
+        return p_page->texture;
+    }
+    p_page->used_msec = pages_msec;
+    p_page->used_frame = pages_frame;
+    if (pages_draw_owner && pages_draw_owner != p_page->last_drawer) {
+        p_page->drawn_by.insert(pages_draw_owner);
+        p_page->last_drawer = pages_draw_owner;
+    }
+    if (!p_page->variants.empty()) {
+        p_page->draw_scale = MAX(p_page->draw_scale, pages_draw_scale);
+    }
+    if (p_page->texture.is_null() && !p_page->pending && !p_page->requested) {
+        if (page_settings.lazy_load_mode == PAGE_LOAD_DEFERRED) {
+            p_page->requested = true;
+            MutexLock lock(pages_mutex);
+            requested_pages.push_back(p_page);
+        } else {
+            spine_set_page_texture(p_page, spine_load_page_texture(spine_page_path(p_page), Ref<Image>()));
+            // a page that failed to load stays requested and is not retried
+            p_page->requested = p_page->texture.is_null();
+            pages_loaded_lazily++;
+        }
+    }
+    return p_page->texture;
+}
+
+// Imported textures only keep their source file in the editor; exported
+// games read those back from the texture instead.
+Ref<Image> SpineRuntime::get_page_image(SpinePage *p_page) {
+    ERR_FAIL_COND_V(!p_page, Ref<Image>());
+    if (p_page->image.is_valid()) {
+        // decoded, waiting for finalize_textures()
+        return p_page->image->duplicate();
+    }
+    if (!p_page->path.empty() && FileAccess::exists(p_page->path)) {
+        Ref<Image> image;
+        image.instance();
+        if (image->load(p_page->path) == OK) {
+            return image;
+        }
+    }
+    Ref<Texture> texture = p_page->texture;
+    if (texture.is_null() && !p_page->path.empty()) {
+        texture = ResourceLoader::load(p_page->path, "Texture");
+    }
+    return texture.is_valid() ? texture->get_data() : Ref<Image>();
+}
+
+void SpineRuntime::set_draw_scale(float p_scale) {
+    pages_draw_scale = p_scale;
+}
+
+void SpineRuntime::set_draw_owner(ObjectID p_owner) {
+    pages_draw_owner = p_owner;
+}
+
+// Whether a visible canvas item still shows the page's texture.
+static bool spine_page_on_screen(const SpinePage *p_page) {
+    for (Set<ObjectID>::Element *E = p_page->drawn_by.front(); E; E = E->next()) {
+        CanvasItem *item = spine_page_drawer(E->get());
+        if (item && item->is_inside_tree() && item->is_visible_in_tree()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Called with pages_mutex held; the caller removes the page from pending_pages.
+static void spine_finalize_page(SpinePage *p_page) {
+    spine_set_page_texture(p_page, spine_load_page_texture(p_page->path, p_page->image));
+    p_page->image = Ref<Image>();
+    p_page->pending = false;
+    pending_page_count.decrement();
+}
+
+int SpineRuntime::finalize_textures(int p_max) {
+    MutexLock lock(pages_mutex);
+    ERR_FAIL_COND_V_MSG(Thread::get_caller_id() != Thread::get_main_id(), pending_pages.size(), "Spine textures can only be created on the main thread");
+    int count = p_max < 0 ? pending_pages.size() : MIN(p_max, pending_pages.size());
+    while (count-- > 0) {
+        int last = pending_pages.size() - 1;
+        spine_finalize_page(pending_pages[last]);
+        pending_pages.resize(last);
+    }
+    return pending_pages.size();
+}
+
+int SpineRuntime::finalize_pages(Vector<SpinePage *> &r_pages, int p_max) {
+    MutexLock lock(pages_mutex);
+    ERR_FAIL_COND_V_MSG(Thread::get_caller_id() != Thread::get_main_id(), r_pages.size(), "Spine textures can only be created on the main thread");
+    int count = p_max < 0 ? r_pages.size() : p_max;
+    for (int i = r_pages.size() - 1; i >= 0; i--) {
+        SpinePage *page = r_pages[i];
+        if (page->pending && count > 0) {
+            count--;
+            pending_pages.erase(page);
+            spine_finalize_page(page);
+        }
+        if (!page->pending) {
+            // finalized here or by an earlier finalize_textures()
+            r_pages.remove(i);
+        }
+    }
+    return r_pages.size();
+}
+
+int SpineRuntime::get_pending_texture_count() {
+    return pending_page_count.get();
+}
+
+static void spine_drop_page_variant(SpinePage *p_page, int p_index) {
+    p_page->variants.remove(p_index);
+    if (p_page->variant > p_index) {
+        p_page->variant--;
+    }
+}
+
+// Installs variant p_variant of p_page from p_texture, or drops the variant
+// when it can't be used.
+static void spine_swap_page_variant(SpinePage *p_page, int p_variant, const Ref<Texture> &p_texture) {
+    const SpinePage::Variant &variant = p_page->variants[p_variant];
+    if (p_texture.is_null()) {
+        spine_drop_page_variant(p_page, p_variant);
+        return;
+    }
+    if (ABS(p_texture->get_width() - p_page->width * variant.scale) > 1 || ABS(p_texture->get_height() - p_page->height * variant.scale) > 1) {
+        WARN_PRINT("Spine atlas page variant is not a uniform rescale of its page: " + variant.path);
+        spine_drop_page_variant(p_page, p_variant);
+        return;
+    }
+    if (p_page->texture.is_valid()) {
+        spine_set_page_texture(p_page, p_texture);
+    }
+    // an evicted page only remembers the variant for its next load
+    p_page->variant = p_variant;
+    p_page->scale_msec = pages_msec;
+    pages_variant_swaps++;
+}
+
+// Swaps in the variants decoded by the workers since the last call.
+static void spine_finish_variant_decodes() {
+    MutexLock lock(decode_mutex);
+    for (int i = 0; i < decoded_variants.size(); i++) {
+        SpinePageDecode *decode = decoded_variants[i];
+        if (decode->page) {
+            decode->page->variant_decode = NULL;
+            Ref<Texture> texture;
+            if (decode->image.is_valid()) {
+                texture = spine_load_page_texture(decode->path, decode->image);
+            } else {
+                ERR_PRINT("Can't load spine atlas page: " + decode->path);
+            }
+            spine_swap_page_variant(decode->page, decode->variant, texture);
+        }
+        memdelete(decode);
+    }
+    decoded_variants.clear();
+}
+
+// Moves pages drawn since the last call to the smallest variant covering
+// the highest on-screen scale they were drawn at, starting at most p_max
+// swaps. Higher resolutions are swapped in right away, lower ones only
+// once the loaded one has not been needed for variant_downscale_delay.
+// Raw images are decoded by the workers and swapped in by a later update,
+// the loaded texture staying in use meanwhile; imported textures can only
+// be loaded on the main thread and are swapped here.
+// Regions keep their uvs, which are relative to the page size.
+static void spine_update_page_variants(int p_max) {
+    float bias = page_settings.variant_scale_bias;
+    float max_scale = page_settings.max_variant_scale;
+    uint64_t delay = page_settings.variant_downscale_delay_msec;
+    Vector<SpinePage *> swaps;
+    Vector<int> targets;
+    {
+        MutexLock lock(pages_mutex);
+        for (int i = 0; i < pages.size(); i++) {
+            SpinePage *page = pages[i];
+            if (page->draw_scale <= 0) {
+                continue;
+            }
+            float scale = page->draw_scale * bias;
+            page->draw_scale = 0;
+            int target = 0;
+            while (page->variants[target].scale < scale && target + 1 < page->variants.size() && page->variants[target + 1].scale <= max_scale) {
+                target++;
+            }
+            if (target >= page->variant) {
+                page->scale_msec = pages_msec;
+            }
+            if (target == page->variant || (target < page->variant && pages_msec - page->scale_msec < delay) || page->pending || page->variant_decode) {
+                continue;
+            }
+            if (page->texture.is_null()) {
+                // not loaded yet, the next load picks the variant up
+                page->variant = target;
+            } else if (swaps.size() < p_max) {
+                swaps.push_back(page);
+                targets.push_back(target);
+            }
+        }
+    }
+    Vector<SpinePageDecode *> decodes;
+    for (int i = 0; i < swaps.size(); i++) {
+        SpinePage *page = swaps[i];
+        const String &path = page->variants[targets[i]].path;
+        if (ResourceLoader::exists(path, "Texture")) {
+            spine_swap_page_variant(page, targets[i], spine_load_page_texture(path, Ref<Image>()));
+            continue;
+        }
+        SpinePageDecode *decode = memnew(SpinePageDecode);
+        decode->path = path;
+        decode->page = page;
+        decode->variant = targets[i];
+        page->variant_decode = decode;
+        decodes.push_back(decode);
+    }
+    if (decodes.size()) {
+        spine_queue_decodes(decodes);
+    }
+}
+
+// Forgets freed canvas items.
+static void spine_prune_page_drawers() {
+    MutexLock lock(pages_mutex);
+    for (int i = 0; i < pages.size(); i++) {
+        Set<ObjectID> &drawn_by = pages[i]->drawn_by;
+        for (Set<ObjectID>::Element *E = drawn_by.front(); E;) {
+            Set<ObjectID>::Element *next = E->next();
+            if (!spine_page_drawer(E->get())) {
+                drawn_by.erase(E);
+            }
+            E = next;
+        }
+    }
+}
+
+void SpineRuntime::update_pages() {
+    if (Thread::get_caller_id() != Thread::get_main_id()) {
+        return;
+    }
+    uint64_t frame = Engine::get_singleton()->get_idle_frames();
+    if (frame == pages_frame) {
+        return;
+    }
+    pages_frame = frame;
+    pages_msec = OS::get_singleton()->get_ticks_msec();
+    if (pages_msec >= page_settings_next_read) {
+        page_settings_next_read = pages_msec + 1000;
+        spine_read_page_settings();
+        spine_prune_page_drawers();
+    }
+    if (get_pending_texture_count()) {
+        finalize_textures();
+    }
+    int loads = page_settings.deferred_loads_per_frame;
+    while (loads-- > 0) {
+        SpinePage *page = NULL;
+        {
+            MutexLock lock(pages_mutex);
+            if (requested_pages.empty()) break;
+            page = requested_pages[0];
+            requested_pages.remove(0);
+        }
+        spine_set_page_texture(page, spine_load_page_texture(spine_page_path(page), Ref<Image>()));
+        page->requested = page->texture.is_null();
+        pages_loaded_lazily++;
+    }
+    spine_finish_variant_decodes();
+    spine_update_page_variants(page_settings.deferred_loads_per_frame);
+    int budget = page_settings.memory_budget;
+    if (pages_msec >= pages_next_eviction && (budget > 0 || page_settings.lazy_pages)) {
+        pages_next_eviction = pages_msec + 1000;
+        evict_pages(page_settings.evict_after_msec, budget);
+    }
+}
+
+struct SpinePageLRU {
+    _FORCE_INLINE_ bool operator()(const SpinePage *p_a, const SpinePage *p_b) const {
+        return p_a->used_msec < p_b->used_msec;
+    }
+};
+
+// Drops the least recently drawn page textures that have not been used for
+// p_unused_msec until the total is back within p_budget bytes (every such
+// page when p_budget is 0). Pages a visible item last drew with are kept,
+// even when it no longer redraws. Evicted pages load again on their next
+// draw.
+// Returns the number of evicted pages.
+int SpineRuntime::evict_pages(uint64_t p_unused_msec, int p_budget) {
+    ERR_FAIL_COND_V_MSG(Thread::get_caller_id() != Thread::get_main_id(), 0, "Spine textures can only be evicted on the main thread");
+    MutexLock lock(pages_mutex);
+    uint64_t total = 0;
+    Vector<SpinePage *> candidates;
+    for (int i = 0; i < pages.size(); i++) {
+        SpinePage *page = pages[i];
+        total += page->bytes;
+        if (page->texture.is_valid() && !page->pending && !page->path.empty() && page->used_frame != pages_frame && pages_msec - page->used_msec >= p_unused_msec && !spine_page_on_screen(page)) {
+            candidates.push_back(page);
+        }
+    }
+    if (candidates.empty() || (p_budget > 0 && total <= (uint64_t)p_budget)) {
+        return 0;
+    }
+    candidates.sort_custom<SpinePageLRU>();
+    int evicted = 0;
+    for (int i = 0; i < candidates.size() && (p_budget <= 0 || total > (uint64_t)p_budget); i++) {
+        total -= candidates[i]->bytes;
+        spine_set_page_texture(candidates[i], Ref<Texture>());
+        evicted++;
+    }
+    pages_evicted += evicted;
+    return evicted;
+}
+
+Dictionary SpineRuntime::get_page_stats() {
+    MutexLock lock(pages_mutex);
+    int loaded = 0;
+    uint64_t bytes = 0;
+    for (int i = 0; i < pages.size(); i++) {
+        loaded += pages[i]->texture.is_valid();
+        bytes += pages[i]->bytes;
+    }
+    Dictionary stats;
+    stats["pages"] = pages.size();
+    stats["loaded"] = loaded;
+    stats["pending"] = pending_pages.size();
+    stats["requested"] = requested_pages.size();
+    stats["bytes"] = bytes;
+    stats["budget"] = GLOBAL_GET("spine/textures/memory_budget");
+    stats["loaded_lazily"] = pages_loaded_lazily;
+    stats["evicted"] = pages_evicted;
+    stats["variant_swaps"] = pages_variant_swaps;
+    return stats;
+}
+
+static thread_local Vector<float> scratch_vertices;
+
+float *SpineRuntime::get_scratch_vertices(int p_count) {
+    if (scratch_vertices.size() < p_count) {
+        scratch_vertices.resize(next_power_of_2(p_count));
+    }
+    return scratch_vertices.ptrw();
+}
+
+int SpineRuntime::get_scratch_memory() {
+    return scratch_vertices.size() * sizeof(float);
+}
+
 void SpineRuntime::_bind_methods() {
-    ADD_SIGNAL(MethodInfo("event"));
+    ClassDB::bind_method(D_METHOD("_on_attachment_node_exiting", "node"), &SpineRuntime::_on_attachment_node_exiting);
+    ClassDB::bind_method(D_METHOD("_on_attachment_node_entered", "node"), &SpineRuntime::_on_attachment_node_entered);
+}
+
+void SpineRuntime::_set_mix_override(const void *p_from, const void *p_to, float p_duration) {
+    for (int i = 0; i < mix_overrides.size(); i++) {
+        if (mix_overrides[i].from == p_from && mix_overrides[i].to == p_to) {
+            mix_overrides.write[i].duration = p_duration;
+            return;
+        }
+    }
+    MixOverride mix = { p_from, p_to, p_duration };
+    mix_overrides.push_back(mix);
+}
+
+// p_bytes were measured while creating the runtime, p_skeleton_bytes of
+// them for the skeleton, which is counted by its arena when it has one.
+// Stays 0 in heap mode without tracking, see SpineAllocator::MeasureScope.
+void SpineRuntime::_set_instance_bytes(uint64_t p_bytes, uint64_t p_skeleton_bytes) {
+    uint64_t arena = skeleton_arena.get_reserved();
+    instance_bytes = arena ? p_bytes - MIN(p_skeleton_bytes, p_bytes) + arena : p_bytes;
+}
+
+SpineRuntime::SpineRuntime() {
+    instance_bytes = 0;
+    events.set_capacity(GLOBAL_GET("spine/events/buffer_size"));
 }
 
 Ref<SpineRuntime> SpineResource::create_runtime() {
-#ifdef SPINE_RUNTIME_3_6_ENABLED    
-    if (runtime_version == "3_6") {
-        return SpineRuntime_3_6::with_resource(Ref<SpineResource>(this));
-    } else 
-#endif
-#ifdef SPINE_RUNTIME_3_7_ENABLED    
-    if (runtime_version == "3_7") {
-        return SpineRuntime_3_7::with_resource(Ref<SpineResource>(this));
-    } else 
-#endif
-#ifdef SPINE_RUNTIME_3_8_ENABLED    
-    if (runtime_version == "3_8") {
-        return SpineRuntime_3_8::with_resource(Ref<SpineResource>(this));
-    } else 
-#endif
-#ifdef SPINE_RUNTIME_4_0_ENABLED    
-    if (runtime_version == "4_0") {
-        return SpineRuntime_4_0::with_resource(Ref<SpineResource>(this));
-    } else
-#endif
-#ifdef SPINE_RUNTIME_4_1_ENABLED    
-    if (runtime_version == "4_1") {
-        return SpineRuntime_4_1::with_resource(Ref<SpineResource>(this));
-    } else
-#endif
+    SPINE_RESOURCE_DISPATCH(return, with_resource(Ref<SpineResource>(this)))
     {
         ERR_FAIL_V_MSG(Ref<SpineResource>(), "No suitable spine runtime found");
     }
@@ -163,4 +1784,358 @@ bool SpineResource::_get(const StringName &p_name, Variant &r_ret) const {
 }
 void SpineResource::_get_property_list(List<PropertyInfo> *p_list) const {
     p_list->push_back(PropertyInfo(Variant::STRING, "runtime_version", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_EDITOR));
-}
\ No newline at end of file
+}
+
+int SpineResource::find_bone_id(const StringName &p_name) const {
+    const int *id = bone_ids.getptr(p_name);
+    return id ? *id : -1;
+}
+
+int SpineResource::find_slot_id(const StringName &p_name) const {
+    const int *id = slot_ids.getptr(p_name);
+    return id ? *id : -1;
+}
+
+int SpineResource::find_animation_id(const StringName &p_name) const {
+    const int *id = animation_ids.getptr(p_name);
+    return id ? *id : -1;
+}
+
+int SpineResource::find_skin_id(const StringName &p_name) const {
+    const int *id = skin_ids.getptr(p_name);
+    return id ? *id : -1;
+}
+
+Array SpineResource::get_animation_names() const {
+    Array names;
+    for (int i = 0; i < animation_names.size(); i++) {
+        names.push_back(String(animation_names[i]));
+    }
+    return names;
+}
+
+Array SpineResource::get_skin_names() const {
+    Array names;
+    for (int i = 0; i < skin_names.size(); i++) {
+        names.push_back(String(skin_names[i]));
+    }
+    return names;
+}
+
+float SpineResource::get_animation_length(const StringName &p_name) const {
+    int id = find_animation_id(p_name);
+    return id < 0 ? 0.0 : animation_durations[id];
+}
+
+void SpineResource::index_properties(PropertyTarget p_target, const String &p_name, int p_index) {
+    Property property;
+    property.target = p_target;
+    property.index = p_index;
+    switch (p_target) {
+        case PROPERTY_BONE: {
+            property.field = FIELD_ROTATION;
+            properties.set("bone/" + p_name + "/rotation", property);
+            property.field = FIELD_POSITION;
+            properties.set("bone/" + p_name + "/position", property);
+        } break;
+        case PROPERTY_SLOT: {
+            property.field = FIELD_COLOR;
+            properties.set("slot/" + p_name + "/color", property);
+        } break;
+        case PROPERTY_PATH: {
+            property.field = FIELD_POSITION;
+            properties.set("path/" + p_name + "/position", property);
+            property.field = FIELD_TRANSLATE_MIX;
+            properties.set("path/" + p_name + "/tmix", property);
+            property.field = FIELD_ROTATE_MIX;
+            properties.set("path/" + p_name + "/rmix", property);
+            property.field = FIELD_SPACING;
+            properties.set("path/" + p_name + "/spacing", property);
+        } break;
+    }
+}
+
+void SpineResource::set_pose_cache_memory_limit(int p_bytes) {
+    pose_cache.set_memory_limit(p_bytes);
+}
+
+int SpineResource::get_pose_cache_memory_limit() const {
+    return pose_cache.get_memory_limit();
+}
+
+void SpineResource::set_pose_cache_fps(float p_fps) {
+    pose_cache.set_fps(p_fps);
+}
+
+float SpineResource::get_pose_cache_fps() const {
+    return pose_cache.get_fps();
+}
+
+Dictionary SpineResource::get_pose_cache_stats() const {
+    return pose_cache.get_stats();
+}
+
+void SpineResource::clear_pose_cache() {
+    pose_cache.clear();
+}
+
+// Resamples curve timelines into fixed-step tables evaluated in O(1).
+// Every converted timeline is checked against the stock evaluation and
+// kept only if it stays within p_tolerance.
+Dictionary SpineResource::bake_timelines(float p_fps, int p_max_bytes_per_animation, float p_tolerance) {
+    SPINE_RESOURCE_DISPATCH(return, bake_timelines(Ref<SpineResource>(this), p_fps, p_max_bytes_per_animation, p_tolerance))
+    {
+        ERR_FAIL_V_MSG(Dictionary(), "No suitable spine runtime found");
+    }
+}
+
+// Removes bone keys that linear interpolation of their neighbours
+// reproduces within the given tolerances. Returns timeline memory and key
+// counts before and after. Timelines already baked by bake_timelines() are
+// left as they are.
+Dictionary SpineResource::compress_timelines(float p_translate_tolerance, float p_rotate_tolerance, float p_scale_tolerance) {
+    SPINE_RESOURCE_DISPATCH(return, compress_timelines(Ref<SpineResource>(this), p_translate_tolerance, p_rotate_tolerance, p_scale_tolerance))
+    {
+        ERR_FAIL_V_MSG(Dictionary(), "No suitable spine runtime found");
+    }
+}
+
+// Mixes live in the AnimationStateData shared by all runtimes of this
+// resource; Spine.mix() only overrides them for a single instance.
+void SpineResource::set_mix(const String &p_from, const String &p_to, float p_duration) {
+    int from = find_animation_id(p_from);
+    int to = find_animation_id(p_to);
+    ERR_FAIL_COND_MSG(from < 0, "Unknown animation: " + p_from);
+    ERR_FAIL_COND_MSG(to < 0, "Unknown animation: " + p_to);
+    mixes.set(((uint64_t)from << 32) | (uint32_t)to, p_duration);
+    if (!state_data) return;
+    SPINE_RESOURCE_DISPATCH(, set_resource_mix(Ref<SpineResource>(this), from, to, p_duration))
+    {
+        ERR_FAIL_MSG("No suitable spine runtime found");
+    }
+}
+
+float SpineResource::get_mix(const String &p_from, const String &p_to) const {
+    int from = find_animation_id(p_from);
+    int to = find_animation_id(p_to);
+    if (from < 0 || to < 0) return default_mix;
+    const float *duration = mixes.getptr(((uint64_t)from << 32) | (uint32_t)to);
+    return duration ? *duration : default_mix;
+}
+
+void SpineResource::set_default_mix(float p_duration) {
+    default_mix = p_duration;
+    if (!state_data) return;
+    SPINE_RESOURCE_DISPATCH(, set_resource_mix(Ref<SpineResource>(this), -1, -1, p_duration))
+    {
+        ERR_FAIL_MSG("No suitable spine runtime found");
+    }
+}
+
+float SpineResource::get_default_mix() const {
+    return default_mix;
+}
+
+// {"default": 0.2, "mixes": {"walk": {"run": 0.3, "idle": 0.1}}}
+void SpineResource::set_mixes(const Dictionary &p_mixes) {
+    if (p_mixes.has("default")) {
+        set_default_mix(p_mixes["default"]);
+    }
+    Dictionary table = p_mixes.get("mixes", Dictionary());
+    for (const Variant *from = table.next(NULL); from; from = table.next(from)) {
+        Dictionary targets = table[*from];
+        for (const Variant *to = targets.next(NULL); to; to = targets.next(to)) {
+            set_mix(*from, *to, targets[*to]);
+        }
+    }
+}
+
+Dictionary SpineResource::get_mixes() const {
+    Dictionary table;
+    for (const uint64_t *key = mixes.next(NULL); key; key = mixes.next(key)) {
+        String from = animation_names[*key >> 32];
+        Dictionary targets = table.get(from, Dictionary());
+        targets[String(animation_names[*key & 0xffffffff])] = mixes[*key];
+        table[from] = targets;
+    }
+    Dictionary result;
+    result["default"] = default_mix;
+    result["mixes"] = table;
+    return result;
+}
+
+Error SpineResource::load_mixes(const String &p_path) {
+    Error err;
+    String text = FileAccess::get_file_as_string(p_path, &err);
+    ERR_FAIL_COND_V_MSG(err != OK, err, "Can't open spine mixes file: " + p_path);
+    Variant parsed;
+    String err_text;
+    int err_line;
+    err = JSON::parse(text, parsed, err_text, err_line);
+    ERR_FAIL_COND_V_MSG(err != OK, err, vformat("%s:%d: %s", p_path, err_line, err_text));
+    ERR_FAIL_COND_V_MSG(parsed.get_type() != Variant::DICTIONARY, ERR_PARSE_ERROR, "Spine mixes file must contain an object: " + p_path);
+    set_mixes(parsed);
+    return OK;
+}
+
+// Runtimes handed out by acquire_runtime() come from the pool when one is
+// available. release_runtime() resets a runtime to the setup pose and keeps
+// it for the next acquire, up to pool_max_size.
+Ref<SpineRuntime> SpineResource::acquire_runtime() {
+    uint64_t begin = OS::get_singleton()->get_ticks_usec();
+    Ref<SpineRuntime> rt;
+    if (runtime_pool.size()) {
+        rt = runtime_pool[runtime_pool.size() - 1];
+        runtime_pool.resize(runtime_pool.size() - 1);
+        rt->resource = Ref<SpineResource>(this);
+        pool_hits++;
+    } else {
+        rt = create_runtime();
+        pool_misses++;
+    }
+    uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+    spawn_usec_total += elapsed;
+    spawn_usec_max = MAX(spawn_usec_max, elapsed);
+    return rt;
+}
+
+void SpineResource::release_runtime(const Ref<SpineRuntime> &p_runtime) {
+    ERR_FAIL_COND(p_runtime.is_null());
+    ERR_FAIL_COND_MSG(p_runtime->resource.ptr() != this, "Runtime was not created from this resource");
+    pool_released++;
+    if (runtime_pool.size() >= pool_max_size) {
+        pool_dropped++;
+        return;
+    }
+    p_runtime->recycle();
+    p_runtime->resource = Ref<SpineResource>();
+    runtime_pool.push_back(p_runtime);
+}
+
+void SpineResource::prewarm_runtimes(int p_count) {
+    p_count = MIN(p_count, pool_max_size);
+    while (runtime_pool.size() < p_count) {
+        Ref<SpineRuntime> rt = create_runtime();
+        ERR_FAIL_COND(rt.is_null());
+        rt->resource = Ref<SpineResource>();
+        runtime_pool.push_back(rt);
+    }
+}
+
+void SpineResource::clear_runtime_pool() {
+    runtime_pool.clear();
+}
+
+void SpineResource::set_pool_max_size(int p_size) {
+    pool_max_size = MAX(p_size, 0);
+    if (runtime_pool.size() > pool_max_size) {
+        runtime_pool.resize(pool_max_size);
+    }
+}
+
+int SpineResource::get_pool_max_size() const {
+    return pool_max_size;
+}
+
+// Page textures are queued globally since atlases are shared between
+// resources; these are kept for scripts driving their own loading.
+int SpineResource::finalize_textures(int p_max) {
+    return SpineRuntime::finalize_pages(queued_pages, p_max);
+}
+
+int SpineResource::get_pending_texture_count() const {
+    MutexLock lock(pages_mutex);
+    int count = 0;
+    for (int i = 0; i < queued_pages.size(); i++) {
+        count += queued_pages[i]->pending;
+    }
+    return count;
+}
+
+Dictionary SpineResource::get_load_stats() const {
+    Dictionary stats;
+    stats["bytes"] = load_bytes;
+    stats["read_usec"] = load_read_usec;
+    stats["parse_usec"] = load_parse_usec;
+    stats["memory"] = load_memory;
+    return stats;
+}
+
+Dictionary SpineResource::get_pool_stats() const {
+    uint64_t acquired = pool_hits + pool_misses;
+    Dictionary stats;
+    stats["pooled"] = runtime_pool.size();
+    stats["hits"] = pool_hits;
+    stats["misses"] = pool_misses;
+    stats["released"] = pool_released;
+    stats["dropped"] = pool_dropped;
+    stats["spawn_usec_avg"] = acquired ? (double)spawn_usec_total / acquired : 0.0;
+    stats["spawn_usec_max"] = spawn_usec_max;
+    return stats;
+}
+
+void SpineResource::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("find_bone_id", "name"), &SpineResource::find_bone_id);
+    ClassDB::bind_method(D_METHOD("find_slot_id", "name"), &SpineResource::find_slot_id);
+    ClassDB::bind_method(D_METHOD("find_animation_id", "name"), &SpineResource::find_animation_id);
+    ClassDB::bind_method(D_METHOD("find_skin_id", "name"), &SpineResource::find_skin_id);
+    ClassDB::bind_method(D_METHOD("get_animation_names"), &SpineResource::get_animation_names);
+    ClassDB::bind_method(D_METHOD("get_skin_names"), &SpineResource::get_skin_names);
+    ClassDB::bind_method(D_METHOD("get_animation_length", "name"), &SpineResource::get_animation_length);
+    ClassDB::bind_method(D_METHOD("set_pose_cache_memory_limit", "bytes"), &SpineResource::set_pose_cache_memory_limit);
+    ClassDB::bind_method(D_METHOD("get_pose_cache_memory_limit"), &SpineResource::get_pose_cache_memory_limit);
+    ClassDB::bind_method(D_METHOD("set_pose_cache_fps", "fps"), &SpineResource::set_pose_cache_fps);
+    ClassDB::bind_method(D_METHOD("get_pose_cache_fps"), &SpineResource::get_pose_cache_fps);
+    ClassDB::bind_method(D_METHOD("get_pose_cache_stats"), &SpineResource::get_pose_cache_stats);
+    ClassDB::bind_method(D_METHOD("clear_pose_cache"), &SpineResource::clear_pose_cache);
+    ClassDB::bind_method(D_METHOD("bake_timelines", "fps", "max_bytes_per_animation", "tolerance"), &SpineResource::bake_timelines, 60, 262144, 0.01);
+    ClassDB::bind_method(D_METHOD("compress_timelines", "translate_tolerance", "rotate_tolerance", "scale_tolerance"), &SpineResource::compress_timelines, 0.1, 0.1, 0.001);
+    ClassDB::bind_method(D_METHOD("set_mix", "from", "to", "duration"), &SpineResource::set_mix);
+    ClassDB::bind_method(D_METHOD("get_mix", "from", "to"), &SpineResource::get_mix);
+    ClassDB::bind_method(D_METHOD("set_default_mix", "duration"), &SpineResource::set_default_mix);
+    ClassDB::bind_method(D_METHOD("get_default_mix"), &SpineResource::get_default_mix);
+    ClassDB::bind_method(D_METHOD("set_mixes", "mixes"), &SpineResource::set_mixes);
+    ClassDB::bind_method(D_METHOD("get_mixes"), &SpineResource::get_mixes);
+    ClassDB::bind_method(D_METHOD("load_mixes", "path"), &SpineResource::load_mixes);
+    ClassDB::bind_method(D_METHOD("acquire_runtime"), &SpineResource::acquire_runtime);
+    ClassDB::bind_method(D_METHOD("release_runtime", "runtime"), &SpineResource::release_runtime);
+    ClassDB::bind_method(D_METHOD("prewarm_runtimes", "count"), &SpineResource::prewarm_runtimes);
+    ClassDB::bind_method(D_METHOD("clear_runtime_pool"), &SpineResource::clear_runtime_pool);
+    ClassDB::bind_method(D_METHOD("set_pool_max_size", "size"), &SpineResource::set_pool_max_size);
+    ClassDB::bind_method(D_METHOD("get_pool_max_size"), &SpineResource::get_pool_max_size);
+    ClassDB::bind_method(D_METHOD("get_pool_stats"), &SpineResource::get_pool_stats);
+    ClassDB::bind_method(D_METHOD("finalize_textures", "max"), &SpineResource::finalize_textures, -1);
+    ClassDB::bind_method(D_METHOD("get_pending_texture_count"), &SpineResource::get_pending_texture_count);
+    ClassDB::bind_method(D_METHOD("get_load_stats"), &SpineResource::get_load_stats);
+
+    ADD_PROPERTY(PropertyInfo(Variant::REAL, "default_mix", PROPERTY_HINT_RANGE, "0,10,0.01", PROPERTY_USAGE_EDITOR), "set_default_mix", "get_default_mix");
+    ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "mixes", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_EDITOR), "set_mixes", "get_mixes");
+
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "pool_max_size", PROPERTY_HINT_RANGE, "0,4096,1"), "set_pool_max_size", "get_pool_max_size");
+
+    ADD_GROUP("Pose Cache", "pose_cache_");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "pose_cache_memory_limit", PROPERTY_HINT_RANGE, "0,268435456,1024"), "set_pose_cache_memory_limit", "get_pose_cache_memory_limit");
+    ADD_PROPERTY(PropertyInfo(Variant::REAL, "pose_cache_fps", PROPERTY_HINT_RANGE, "1,240,1"), "set_pose_cache_fps", "get_pose_cache_fps");
+}
+
+SpineResource::SpineResource() {
+    atlas = NULL;
+    data = NULL;
+    state_data = NULL;
+    default_mix = 0;
+    pool_max_size = GLOBAL_GET("spine/pool/max_size");
+    pool_hits = pool_misses = pool_released = pool_dropped = 0;
+    spawn_usec_total = spawn_usec_max = 0;
+    load_bytes = load_read_usec = load_parse_usec = load_memory = 0;
+    pose_cache.set_memory_limit(GLOBAL_GET("spine/pose_cache/memory_limit"));
+    pose_cache.set_fps(GLOBAL_GET("spine/pose_cache/fps"));
+}
+
+SpineResource::~SpineResource() {
+    // pooled runtimes still point into the skeleton data
+    runtime_pool.clear();
+    SPINE_RESOURCE_DISPATCH(, free_resource(this))
+    {
+        // nothing was loaded
+    }
+}
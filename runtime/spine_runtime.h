@@ -2,40 +2,382 @@
 #define SPINE_RUNTIME_H
 
 #include "core/resource.h"
+#include "core/hash_map.h"
+#include "core/set.h"
 #include "scene/resources/shape_2d.h"
+#include "scene/resources/texture.h"
 
 #include "modules/spine/spine_batcher.h"
+#include "modules/spine/runtime/spine_pose_cache.h"
+#include "modules/spine/runtime/spine_event_buffer.h"
+#include "modules/spine/runtime/spine_allocator.h"
 
+class Node2D;
 class SpineRuntime;
+struct SpinePageDecode;
+
+// Texture of one atlas page, stored as the page's renderer object.
+struct SpinePage {
+    // the page exported at another resolution with the same region layout
+    struct Variant {
+        String path;
+        float scale;
+
+        bool operator<(const Variant &p_other) const { return scale < p_other.scale; }
+    };
+
+    String path;
+    Ref<Texture> texture;
+    // decoded off the main thread, waiting for finalize_textures()
+    Ref<Image> image;
+    bool pending;
+    bool requested;
+    // last draw; only written and read on the main thread
+    uint64_t used_msec;
+    uint64_t used_frame;
+    int bytes;
+
+    // sorted by scale, including the page itself at scale 1; empty when the
+    // atlas has no variants
+    Vector<Variant> variants;
+    int variant;
+    // page size at scale 1
+    int width;
+    int height;
+    // highest on-screen scale the page was drawn at since the last update,
+    // main thread only
+    float draw_scale;
+    // last time the loaded variant was needed
+    uint64_t scale_msec;
+    // variant being decoded by a worker; the loaded texture stays in use
+    // until it is ready
+    SpinePageDecode *variant_decode;
+    // canvas items that drew the current texture, redrawn when it changes;
+    // main thread only
+    Set<ObjectID> drawn_by;
+    ObjectID last_drawer;
+};
+
+// Atlas pages and regions as a runtime parsed them, cooked at import so
+// loads build the atlas without parsing its text, see
+// SpineRuntime::cook_atlas(). Regions refer to pages by index.
+struct SpineAtlasTable {
+    struct Page {
+        String name;
+        int format;
+        int min_filter;
+        int mag_filter;
+        int u_wrap;
+        int v_wrap;
+        int width;
+        int height;
+        bool pma;
+    };
+    struct Region {
+        int page;
+        String name;
+        int x, y, width, height;
+        float u, v, u2, v2;
+        float offset_x, offset_y;
+        int original_width, original_height;
+        int index;
+        int degrees;
+        Vector<int> splits;
+        Vector<int> pads;
+    };
+    Vector<Page> pages;
+    Vector<Region> regions;
+
+    Vector<uint8_t> encode() const;
+    Error decode(const Vector<uint8_t> &p_data);
+};
+
 class SpineResource: public Resource {
     GDCLASS(SpineResource, Resource);
 protected:
     bool _set(const StringName &p_name, const Variant &p_value);
 	bool _get(const StringName &p_name, Variant &r_ret) const;
 	void _get_property_list(List<PropertyInfo> *p_list) const;
+    static void _bind_methods();
 
 public:
     void *atlas;
     void *data;
+    // AnimationStateData shared by every runtime created from this resource
+    void *state_data;
     String runtime_version;
+    SpinePoseCache pose_cache;
     Ref<SpineRuntime> create_runtime();
+
+    // released runtimes waiting for reuse; they drop their resource
+    // reference while pooled so the pool does not keep the resource alive
+    Vector<Ref<SpineRuntime> > runtime_pool;
+    int pool_max_size;
+    uint64_t pool_hits;
+    uint64_t pool_misses;
+    uint64_t pool_released;
+    uint64_t pool_dropped;
+    uint64_t spawn_usec_total;
+    uint64_t spawn_usec_max;
+
+    // name -> index lookups, filled once by the runtime that loaded the data
+    HashMap<StringName, int> bone_ids;
+    HashMap<StringName, int> slot_ids;
+    HashMap<StringName, int> animation_ids;
+    HashMap<StringName, int> skin_ids;
+    Vector<StringName> animation_names;
+    Vector<float> animation_durations;
+    Vector<StringName> skin_names;
+    Vector<StringName> event_names;
+    HashMap<uint64_t, int> event_ids;
+    // setup pose bounds in node coordinates (y down), empty when the export
+    // carries no size
+    Rect2 bounds;
+
+    // filled by SpineRuntime::parse_skeleton(); memory is what the spine
+    // allocator handed out for the parse and kept, 0 in heap mode without
+    // spine/memory/track_allocations
+    uint64_t load_bytes;
+    uint64_t load_read_usec;
+    uint64_t load_parse_usec;
+    uint64_t load_memory;
+    // pages created for this resource's atlas that were still queued for
+    // finalize_textures() after parsing
+    Vector<SpinePage *> queued_pages;
+
+    // mix durations keyed by (from animation id << 32 | to animation id)
+    HashMap<uint64_t, float> mixes;
+    float default_mix;
+
+    // skins composed by SpineRuntime::set_skins(), keyed by loadout and
+    // shared by the runtimes wearing them
+    HashMap<String, void *> composed_skins;
+
+    // dynamic Spine node properties (bone/<name>/rotation, ...) resolved
+    // to their target once, so get/set never parse the property path
+    enum PropertyTarget {
+        PROPERTY_BONE,
+        PROPERTY_SLOT,
+        PROPERTY_PATH,
+    };
+    enum PropertyField {
+        FIELD_ROTATION,
+        FIELD_POSITION,
+        FIELD_COLOR,
+        FIELD_SPACING,
+        FIELD_TRANSLATE_MIX,
+        FIELD_ROTATE_MIX,
+    };
+    struct Property {
+        PropertyTarget target;
+        PropertyField field;
+        int index;
+    };
+    HashMap<StringName, Property> properties;
+
+    void index_properties(PropertyTarget p_target, const String &p_name, int p_index);
+    _FORCE_INLINE_ const Property *find_property(const StringName &p_name) const { return properties.getptr(p_name); }
+
+    int find_bone_id(const StringName &p_name) const;
+    int find_slot_id(const StringName &p_name) const;
+    int find_animation_id(const StringName &p_name) const;
+    int find_skin_id(const StringName &p_name) const;
+    Array get_animation_names() const;
+    Array get_skin_names() const;
+    float get_animation_length(const StringName &p_name) const;
+    _FORCE_INLINE_ int find_event_id(const void *p_event_data) const {
+        const int *id = event_ids.getptr((uint64_t)p_event_data);
+        return id ? *id : -1;
+    }
+
+    void set_pose_cache_memory_limit(int p_bytes);
+    int get_pose_cache_memory_limit() const;
+    void set_pose_cache_fps(float p_fps);
+    float get_pose_cache_fps() const;
+    Dictionary get_pose_cache_stats() const;
+    void clear_pose_cache();
+
+    Dictionary bake_timelines(float p_fps, int p_max_bytes_per_animation, float p_tolerance);
+    Dictionary compress_timelines(float p_translate_tolerance, float p_rotate_tolerance, float p_scale_tolerance);
+
+    void set_mix(const String &p_from, const String &p_to, float p_duration);
+    float get_mix(const String &p_from, const String &p_to) const;
+    void set_default_mix(float p_duration);
+    float get_default_mix() const;
+    void set_mixes(const Dictionary &p_mixes);
+    Dictionary get_mixes() const;
+    Error load_mixes(const String &p_path);
+
+    Ref<SpineRuntime> acquire_runtime();
+    void release_runtime(const Ref<SpineRuntime> &p_runtime);
+    void prewarm_runtimes(int p_count);
+    void clear_runtime_pool();
+    void set_pool_max_size(int p_size);
+    int get_pool_max_size() const;
+    Dictionary get_pool_stats() const;
+
+    int finalize_textures(int p_max = -1);
+    int get_pending_texture_count() const;
+    Dictionary get_load_stats() const;
+
+    SpineResource();
+    ~SpineResource();
 };
 
 class SpineRuntime: public Reference {
     GDCLASS(SpineRuntime, Reference);
+    friend class SpineResource;
 
 protected:
+    Ref<SpineResource> resource;
+    SpineEventBuffer events;
+    // backs the skeleton's own objects when arenas are enabled; declared in
+    // the base so it is released after the runtime deleted its skeleton
+    SpineAllocator::Arena skeleton_arena;
+    // allocator bytes of the skeleton, animation state and clipper when
+    // created, see _set_instance_bytes()
+    uint64_t instance_bytes;
+    // pose cache misses copy the computed pose through this buffer
+    Vector<float> pose_buffer;
+
+    // per-instance mix durations layered over the resource mix table
+    struct MixOverride {
+        const void *from;
+        const void *to;
+        float duration;
+    };
+    Vector<MixOverride> mix_overrides;
+
+    void _set_mix_override(const void *p_from, const void *p_to, float p_duration);
+    void _set_instance_bytes(uint64_t p_bytes, uint64_t p_skeleton_bytes);
+    _FORCE_INLINE_ const float *_get_mix_override(const void *p_from, const void *p_to) const {
+        for (int i = 0; i < mix_overrides.size(); i++) {
+            const MixOverride &mix = mix_overrides[i];
+            if (mix.from == p_from && mix.to == p_to) return &mix.duration;
+        }
+        return NULL;
+    }
+
     static void _bind_methods();
 
 public:
+    _FORCE_INLINE_ SpineEventBuffer &get_event_buffer() { return events; }
+    uint64_t get_instance_memory() const { return instance_bytes; }
+    _FORCE_INLINE_ void _push_event(SpineEventBuffer::Type p_type, int p_track, const void *p_event_data = NULL, int p_int = 0, float p_float = 0, const char *p_string = NULL) {
+        SpineEventBuffer::Event event = { p_type, p_track, p_event_data ? resource->find_event_id(p_event_data) : -1, p_int, p_float, p_string };
+        events.push(event);
+    }
+
     virtual bool _rt_set(const StringName &p_name, const Variant &p_value) { return false; }
 	virtual bool _rt_get(const StringName &p_name, Variant &r_ret) const { return false; }
 	virtual void _rt_get_property_list(List<PropertyInfo> *p_list) const { };
 
     static void init();
+    // stops the page decode workers and drops unfinished variant swaps
+    static void finish();
     static Ref<SpineResource> load_resource(const String &path);
     static Ref<SpineRuntime> with_resource(Ref<SpineResource>) { return Ref<SpineRuntime>(); };
 
+    // skeleton and atlas file contents, each followed by a terminating zero
+    struct SkeletonSource {
+        String path;
+        String version;
+        String atlas_path;
+        Vector<uint8_t> data;
+        // empty when the atlas was already cached at read time
+        Vector<uint8_t> atlas_data;
+        // encoded SpineAtlasTable of a cooked skeleton, used instead of
+        // parsing atlas_data when the runtime supports it
+        Vector<uint8_t> atlas_table;
+        // page textures fetched by prefetch_textures(), keyed by page path
+        HashMap<String, Ref<Texture> > textures;
+        HashMap<String, Ref<Image> > images;
+        // resolution variants of the atlas pages, keyed by page path
+        HashMap<String, Vector<SpinePage::Variant> > page_variants;
+        // filled by load_page() while parsing
+        mutable Vector<SpinePage *> queued_pages;
+        uint64_t read_usec;
+        // atlas_data was rewritten by merge_atlas_pages()
+        bool merged_pages;
+
+        // atlas cache key, kept apart from the atlas file's when merged
+        String get_atlas_key() const { return merged_pages ? atlas_path + "#merged" : atlas_path; }
+
+        SkeletonSource() { read_usec = 0; merged_pages = false; }
+    };
+
+    // load_resource() split into stages for interactive and threaded loading
+    static Error read_skeleton(const String &p_path, SkeletonSource &r_source);
+    static void prefetch_textures(SkeletonSource &r_source);
+    static Ref<SpineResource> parse_skeleton(const SkeletonSource &p_source);
+    static void finish_resource(Ref<SpineResource> p_res, const String &p_path);
+
+    static bool is_json(const String &p_path);
+    static String probe_version(const String &p_path, const Vector<uint8_t> &p_data);
+    static String find_atlas_path(const String &p_skeleton_path);
+    static Vector<uint8_t> get_atlas_data(const SkeletonSource &p_source);
+    static Vector<String> get_atlas_pages(const String &p_atlas_path, const Vector<uint8_t> &p_atlas_data);
+    static Error merge_atlas_pages(SkeletonSource &r_source, int p_max_size, const String &p_page_base, List<String> *r_files);
+    // packs p_images into one RGBA8 image of at most p_max_size pixels and
+    // stores where each went in r_positions; null when they don't fit
+    static Ref<Image> pack_images(const Vector<Ref<Image> > &p_images, int p_max_size, Vector<Point2> &r_positions);
+    // encoded SpineAtlasTable of the source's atlas, empty when its runtime
+    // only builds atlases from text
+    static Vector<uint8_t> cook_atlas(const SkeletonSource &p_source);
+    static Error save_cooked(const String &p_path, const SkeletonSource &p_source);
+    static Error read_cooked(const String &p_path, SkeletonSource &r_source);
+    static int get_cooked_format_version();
+
+    // totals over every skeleton parsed since start or the last reset
+    static Dictionary get_load_report();
+    static void reset_load_report();
+
+    // renderer object of an atlas page. Off the main thread its texture is
+    // queued for finalize_textures(); with lazy pages it is only loaded the
+    // first time get_page_texture() is asked for it.
+    static SpinePage *load_page(const String &p_path, int *r_width, int *r_height);
+    static SpinePage *create_page(const Ref<Texture> &p_texture);
+    static void unload_page(SpinePage *p_page);
+    static Ref<Texture> get_page_texture(SpinePage *p_page);
+    // CPU copy of a page at any resolution, read from its file when it has
+    // one and loaded synchronously when the page isn't; null on failure
+    static Ref<Image> get_page_image(SpinePage *p_page);
+    // on-screen scale of the skeleton about to be batched on the main
+    // thread; pages with variants are swapped to the matching resolution
+    static void set_draw_scale(float p_scale);
+    // canvas item about to be batched on the main thread, 0 after it
+    static void set_draw_owner(ObjectID p_owner);
+    // creates queued page textures on the main thread, at most p_max of
+    // them (all when negative); returns the number still pending
+    static int finalize_textures(int p_max = -1);
+    static int get_pending_texture_count();
+    // finalize_textures() limited to r_pages, which keeps the ones still
+    // pending
+    static int finalize_pages(Vector<SpinePage *> &r_pages, int p_max = -1);
+    // once per frame on the main thread: finalizes queued pages, serves
+    // deferred lazy loads, swaps page variants and evicts pages over the
+    // texture budget
+    static void update_pages();
+    // main thread only; pages drawn in the current frame are never evicted
+    static int evict_pages(uint64_t p_unused_msec, int p_budget);
+    static Dictionary get_page_stats();
+
+    // atlases are shared by every skeleton of a runtime version that uses
+    // the same atlas file. find_atlas() and share_atlas() add a reference;
+    // share_atlas() returns the already cached atlas when another thread
+    // got there first, and the caller then frees its own. release_atlas()
+    // returns true when the caller dropped the last reference and must
+    // free the atlas.
+    static bool has_atlas(const String &p_version, const String &p_path);
+    static void *find_atlas(const String &p_version, const String &p_path);
+    static void *share_atlas(const String &p_version, const String &p_path, void *p_atlas);
+    static bool release_atlas(void *p_atlas);
+
+    // world vertex scratch shared by all runtimes batching on the calling
+    // thread; valid until the next call on that thread
+    static float *get_scratch_vertices(int p_count);
+    static int get_scratch_memory();
+
     virtual void batch(SpineBatcher* batcher, const Color &modulate, bool flip_x, bool flip_y, bool individual_textures) { }
     virtual void process(float delta) { }
 
@@ -44,6 +386,7 @@ public:
     virtual Array get_skin_names() const { return Array(); }
     virtual bool has_animation(const String& p_name) { return false; }
     virtual bool set_skin(const String& p_name) { return false; }
+    virtual bool set_skins(const Vector<int> &p_skin_ids, bool p_bake) { return false; }
 
     virtual void mix(const String& p_from, const String& p_to, real_t p_duration) { }
     virtual bool play(const String& p_name, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0) { return false; }
@@ -53,6 +396,7 @@ public:
     virtual bool is_playing(int p_track = 0) const { return false; }
     virtual String get_current_animation(int p_track = 0) const { return String(); }
     virtual void reset() { }
+    virtual void recycle() { }
     virtual void seek(int track, float p_pos) { }
     virtual float tell(int track) const { return 0.0; }
 
@@ -66,14 +410,21 @@ public:
     virtual bool has_attachment_node(const String& p_bone_name, const Variant& p_node) { return false; }
 	virtual bool add_attachment_node(const String& p_bone_name, const Variant& p_node, const Vector2& p_ofs = Vector2(0, 0), const Vector2& p_scale = Vector2(1, 1), const real_t p_rot = 0) { return false; }
 	virtual bool remove_attachment_node(const String& p_bone_name, const Variant& p_node) { return false; }
+	virtual void _on_attachment_node_exiting(Object *p_node) { }
+	virtual void _on_attachment_node_entered(Object *p_node) { }
     
     virtual Ref<Shape2D> get_bounding_box(const String& p_slot_name, const String& p_attachment_name) { return Ref<Shape2D>(); }
     virtual bool add_bounding_box(const String& p_bone_name, const String& p_slot_name, const String& p_attachment_name, const Variant& p_node, const Vector2& p_ofs = Vector2(0, 0), const Vector2& p_scale = Vector2(1, 1), const real_t p_rot = 0) { return false; }
 
     virtual Vector2 get_bone_position(const String &bone_name) { return Vector2(); }
     virtual float get_bone_rotation(const String &bone_name) { return 0.0; }
+    virtual bool set_bones_local(const PoolIntArray &p_bone_ids, const PoolVector2Array &p_positions, const PoolRealArray &p_rotations) { return false; }
+
+    virtual bool play_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0) { return false; }
+    virtual bool add_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0) { return false; }
+    virtual Transform2D get_bone_world_by_id(int p_bone_id) const { return Transform2D(); }
 
-    SpineRuntime() { };
+    SpineRuntime();
 };
 
 
@@ -29,11 +29,14 @@
  *****************************************************************************/
 #include "spine.h"
 #include "core/io/resource_loader.h"
+#include "scene/2d/visibility_notifier_2d.h"
+#include "scene/main/viewport.h"
 #include <core/engine.h>
 #include <core/method_bind_ext.gen.inc>
 
 VARIANT_ENUM_CAST(Spine::AnimationProcessMode);
 VARIANT_ENUM_CAST(Spine::DebugAttachmentMode);
+VARIANT_ENUM_CAST(Spine::AnimationEventType);
 
 Array *Spine::invalid_names = NULL;
 Array Spine::get_invalid_names() {
@@ -94,12 +97,46 @@ void Spine::_spine_dispose() {
 		stop();
 	}
 
+	_release_runtime();
 	res = RES();
-	runtime = Ref<SpineRuntime>();
 
 	update();
 }
 
+void Spine::_acquire_runtime() {
+	runtime = res->acquire_runtime();
+	ERR_FAIL_COND(runtime.is_null());
+	event_signal_cursor = event_poll_cursor = runtime->get_event_buffer().get_sequence();
+
+	if (!skin_loadout.empty())
+		runtime->set_skins(skin_loadout, skin_loadout_baked);
+	else if (skin != "")
+		set_skin(skin);
+	if (current_animation != "[stop]")
+		play(current_animation, 1, loop);
+	else
+		reset();
+}
+
+// Runtimes are created on first use: the first draw while the node is on
+// screen, a playback call or a pose query. Metadata comes from the resource.
+bool Spine::_ensure_runtime() {
+	// textures of pages loaded on a worker thread, lazy page loads and
+	// eviction, at most once per frame
+	SpineRuntime::update_pages();
+	if (runtime.is_null() && res.is_valid()) {
+		_acquire_runtime();
+	}
+	return runtime.is_valid();
+}
+
+void Spine::_release_runtime() {
+	if (pool_runtime && runtime.is_valid() && res.is_valid()) {
+		res->release_runtime(runtime);
+	}
+	runtime = Ref<SpineRuntime>();
+}
+
 // static Ref<Texture> spine_get_texture(spRegionAttachment *attachment) {
 
 // 	if (Ref<Texture> *ref = static_cast<Ref<Texture> *>(((spAtlasRegion *)attachment->rendererObject)->page->rendererObject))
@@ -114,11 +151,57 @@ void Spine::_spine_dispose() {
 // 	return NULL;
 // }
 
+// Setup pose bounds of the resource, grown to leave room for animation.
+Rect2 Spine::_get_screen_bounds() const {
+	Rect2 bounds = res->bounds;
+	if (flip_x)
+		bounds.position.x = -bounds.position.x - bounds.size.x;
+	if (flip_y)
+		bounds.position.y = -bounds.position.y - bounds.size.y;
+	return bounds.grow(MAX(bounds.size.x, bounds.size.y) * 0.5);
+}
+
+// Whether the screen bounds intersect the visible part of the viewport.
+bool Spine::_is_on_screen() const {
+	if (res->bounds.has_no_area())
+		return true;
+	Rect2 view = get_canvas_transform().affine_inverse().xform(get_viewport_rect());
+	return view.intersects(get_global_transform().xform(_get_screen_bounds()));
+}
+
+void Spine::_on_screen_entered() {
+	update();
+}
+
 void Spine::_animation_draw() {
-	if (runtime.is_null())
+	if (runtime.is_null()) {
+		if (res.is_null())
+			return;
+		if (!_is_on_screen()) {
+			// nothing to draw yet, the notifier redraws once the node scrolls
+			// into view
+			if (!screen_notifier) {
+				screen_notifier = memnew(VisibilityNotifier2D);
+				screen_notifier->connect("screen_entered", this, "_on_screen_entered");
+				add_child(screen_notifier);
+			}
+			screen_notifier->set_rect(_get_screen_bounds());
+			return;
+		}
+	}
+	if (screen_notifier) {
+		screen_notifier->queue_delete();
+		screen_notifier = NULL;
+	}
+	if (!_ensure_runtime())
 		return;
 
+	// picks the resolution of atlas pages exported with variants
+	Size2 scale = (get_viewport()->get_final_transform() * get_global_transform_with_canvas()).get_scale();
+	SpineRuntime::set_draw_scale(MAX(ABS(scale.x), ABS(scale.y)));
+	SpineRuntime::set_draw_owner(get_instance_id());
 	runtime->batch(&batcher, modulate, flip_x, flip_y, individual_textures);
+	SpineRuntime::set_draw_owner(0);
 }
 
 void Spine::queue_process() {
@@ -144,9 +227,12 @@ void Spine::_animation_process(float p_delta) {
 			frames_to_skip = skip_frames;
 		}
 	}
+	if (runtime.is_null())
+		return;
     current_pos += forward ? process_delta : -process_delta;
 	runtime->process(forward ? process_delta : -process_delta);
 	process_delta = 0;
+	_dispatch_events();
 
 	// spAnimationState_update(state, forward ? process_delta : -process_delta);
 	// spAnimationState_apply(state, skeleton);
@@ -207,13 +293,159 @@ void Spine::_set_process(bool p_process, bool p_force) {
 	processing = p_process;
 }
 
+SpineStringNames *SpineStringNames::singleton = NULL;
+
+SpineStringNames::SpineStringNames() :
+		animation_start("animation_start"),
+		animation_complete("animation_complete"),
+		animation_event("animation_event"),
+		animation_end("animation_end"),
+		playback_play("playback/play"),
+		playback_loop("playback/loop"),
+		playback_forward("playback/forward"),
+		playback_skin("playback/skin"),
+		debug_region("debug/region"),
+		debug_mesh("debug/mesh"),
+		debug_skinned_mesh("debug/skinned_mesh"),
+		debug_bounding_box("debug/bounding_box"),
+		performance_triangles_drawn("performance/triangles_drawn"),
+		performance_triangles_generated("performance/triangles_generated"),
+		performance_draw_calls("performance/draw_calls") {
+}
+
+static const SpineStringNames &spine_string_names() {
+	return *SpineStringNames::get_singleton();
+}
+
+// Forwards buffered runtime events as signals when emit_event_signals is
+// on. Called right after every runtime call that can fire events, so
+// signals go out in the same step. Payloads are only built for event types
+// somebody is connected to.
+void Spine::_dispatch_events() {
+	if (runtime.is_null()) return;
+	SpineEventBuffer &events = runtime->get_event_buffer();
+	if (event_signal_cursor == events.get_sequence()) return;
+
+	const SpineStringNames &names = spine_string_names();
+	const StringName *signals[] = { &names.animation_start, &names.animation_complete, &names.animation_event, &names.animation_end };
+	if (emit_event_signals && event_listeners_frame != Engine::get_singleton()->get_idle_frames()) {
+		event_listeners_frame = Engine::get_singleton()->get_idle_frames();
+		event_listeners = 0;
+		for (int i = 0; i < 4; i++) {
+			List<Connection> connections;
+			get_signal_connection_list(*signals[i], &connections);
+			if (connections.size()) event_listeners |= 1 << i;
+		}
+	}
+	if (!emit_event_signals || !event_listeners) {
+		event_signal_cursor = events.get_sequence();
+		return;
+	}
+
+	while (const SpineEventBuffer::Event *event = events.read(event_signal_cursor)) {
+		if (!(event_listeners & (1 << event->type))) continue;
+		switch (event->type) {
+			case SpineEventBuffer::EVENT_START:
+			case SpineEventBuffer::EVENT_END:
+				emit_signal(*signals[event->type], event->track);
+				break;
+			case SpineEventBuffer::EVENT_COMPLETE:
+				emit_signal(*signals[event->type], event->track, event->int_value);
+				break;
+			case SpineEventBuffer::EVENT_EVENT: {
+				Dictionary data;
+				data["name"] = event->name >= 0 ? res->event_names[event->name] : StringName();
+				data["int"] = event->int_value;
+				data["float"] = event->float_value;
+				data["string"] = event->string_value ? String::utf8(event->string_value) : String();
+				emit_signal(*signals[event->type], event->track, data);
+			} break;
+		}
+	}
+}
+
+// Returns the events buffered since the previous call as parallel packed
+// arrays: type, track, name, int, float and string.
+Dictionary Spine::poll_events() {
+	Dictionary result;
+	if (runtime.is_null()) return result;
+	SpineEventBuffer &events = runtime->get_event_buffer();
+
+	PoolIntArray types;
+	PoolIntArray tracks;
+	PoolStringArray event_names;
+	PoolIntArray ints;
+	PoolRealArray floats;
+	PoolStringArray strings;
+	while (const SpineEventBuffer::Event *event = events.read(event_poll_cursor)) {
+		types.push_back(event->type);
+		tracks.push_back(event->track);
+		event_names.push_back(event->name >= 0 ? String(res->event_names[event->name]) : String());
+		ints.push_back(event->int_value);
+		floats.push_back(event->float_value);
+		strings.push_back(event->string_value ? String::utf8(event->string_value) : String());
+	}
+	result["type"] = types;
+	result["track"] = tracks;
+	result["name"] = event_names;
+	result["int"] = ints;
+	result["float"] = floats;
+	result["string"] = strings;
+	return result;
+}
+
+// Bytes held by this instance for drawing and by its runtime's skeleton,
+// animation state and clipper. Vertex scratch is shared per thread and
+// reported separately.
+Dictionary Spine::get_memory_report() const {
+	Dictionary batch = batcher.get_memory_report();
+	uint64_t runtime_bytes = runtime.is_valid() ? runtime->get_instance_memory() : 0;
+	Dictionary report;
+	report["node_bytes"] = (int)sizeof(Spine);
+	report["batcher_bytes"] = batch["bytes"];
+	report["batcher_commands"] = batch["commands"];
+	report["runtime_bytes"] = runtime_bytes;
+	report["instance_bytes"] = (int)sizeof(Spine) + (int)batch["bytes"] + runtime_bytes;
+	report["thread_scratch_bytes"] = SpineRuntime::get_scratch_memory();
+	return report;
+}
+
+void Spine::set_emit_event_signals(bool p_enable) {
+	emit_event_signals = p_enable;
+	// look connections up again on the next dispatch
+	event_listeners_frame = UINT64_MAX;
+}
+
+bool Spine::is_emitting_event_signals() const {
+	return emit_event_signals;
+}
+
+void Spine::set_pool_runtime(bool p_enable) {
+	pool_runtime = p_enable;
+}
+
+bool Spine::is_pool_runtime() const {
+	return pool_runtime;
+}
+
+// Hands the runtime back to the resource pool without freeing the node,
+// for nodes kept in a scene-level pool. Leaving the tree keeps the runtime,
+// so reparenting does not reset the pose. The next playback call or draw
+// acquires a runtime again.
+void Spine::despawn() {
+	_set_process(false);
+	playing = false;
+	_release_runtime();
+	update();
+}
+
 bool Spine::_set(const StringName &p_name, const Variant &p_value) {
-	if (runtime.is_valid() && runtime->_rt_set(p_name, p_value)) {
+	if (res.is_valid() && res->find_property(p_name) && _ensure_runtime() && runtime->_rt_set(p_name, p_value)) {
 		return true;
 	}
 
-	String name = p_name;
-	if (name == "playback/play") {
+	const SpineStringNames &names = spine_string_names();
+	if (p_name == names.playback_play) {
 
 		String which = p_value;
 		if (runtime.is_valid()) {
@@ -227,70 +459,67 @@ bool Spine::_set(const StringName &p_name, const Variant &p_value) {
 		} else {
 			current_animation = which;
 		}
-	} else if (name == "playback/loop") {
+	} else if (p_name == names.playback_loop) {
 
 		loop = p_value;
-		if (has_animation(current_animation))
+		if (runtime.is_valid() && has_animation(current_animation))
 			play(current_animation, 1, loop);
-	} else if (name == "playback/forward") {
+	} else if (p_name == names.playback_forward) {
 
 		forward = p_value;
-	} else if (name == "playback/skin") {
+	} else if (p_name == names.playback_skin) {
 
 		skin = p_value;
 		if (runtime.is_valid())
 			set_skin(skin);
-	} else if (name == "debug/region")
+	} else if (p_name == names.debug_region)
 		set_debug_attachment(DEBUG_ATTACHMENT_REGION, p_value);
-	else if (name == "debug/mesh")
+	else if (p_name == names.debug_mesh)
 		set_debug_attachment(DEBUG_ATTACHMENT_MESH, p_value);
-	else if (name == "debug/skinned_mesh")
+	else if (p_name == names.debug_skinned_mesh)
 		set_debug_attachment(DEBUG_ATTACHMENT_SKINNED_MESH, p_value);
-	else if (name == "debug/bounding_box")
+	else if (p_name == names.debug_bounding_box)
 		set_debug_attachment(DEBUG_ATTACHMENT_BOUNDING_BOX, p_value);
 
 	return true;
 }
 
 bool Spine::_get(const StringName &p_name, Variant &r_ret) const {
-	if (runtime.is_valid() && runtime->_rt_get(p_name, r_ret)) {
+	if (res.is_valid() && res->find_property(p_name) && const_cast<Spine *>(this)->_ensure_runtime() && runtime->_rt_get(p_name, r_ret)) {
 		return true;
 	}
 
-	String name = p_name;
-
-	if (name == "playback/play") {
+	const SpineStringNames &names = spine_string_names();
+	if (p_name == names.playback_play) {
 
 		r_ret = current_animation;
-	} else if (name == "playback/loop")
+	} else if (p_name == names.playback_loop)
 		r_ret = loop;
-	else if (name == "playback/forward")
+	else if (p_name == names.playback_forward)
 		r_ret = forward;
-	else if (name == "playback/skin")
+	else if (p_name == names.playback_skin)
 		r_ret = skin;
-	else if (name == "debug/region")
+	else if (p_name == names.debug_region)
 		r_ret = is_debug_attachment(DEBUG_ATTACHMENT_REGION);
-	else if (name == "debug/mesh")
+	else if (p_name == names.debug_mesh)
 		r_ret = is_debug_attachment(DEBUG_ATTACHMENT_MESH);
-	else if (name == "debug/skinned_mesh")
+	else if (p_name == names.debug_skinned_mesh)
 		r_ret = is_debug_attachment(DEBUG_ATTACHMENT_SKINNED_MESH);
-	else if (name == "debug/bounding_box")
+	else if (p_name == names.debug_bounding_box)
 		r_ret = is_debug_attachment(DEBUG_ATTACHMENT_BOUNDING_BOX);
-	else if (name == "performance/triangles_drawn") {
+	else if (p_name == names.performance_triangles_drawn) {
 		r_ret = performance_triangles_drawn;
-	} else if (name == "performance/triangles_generated") {
+	} else if (p_name == names.performance_triangles_generated) {
 		r_ret = performance_triangles_generated;
+	} else if (p_name == names.performance_draw_calls) {
+		r_ret = batcher.draw_calls_count();
 	}
 
 	return true;
 }
 
 float Spine::get_animation_length(String p_animation) const {
-	if (runtime.is_valid()) {
-		return runtime->get_animation_length(p_animation);
-	} else {
-		return 0.0;
-	}
+	return res.is_valid() ? res->get_animation_length(p_animation) : 0.0;
 }
 
 void Spine::_get_property_list(List<PropertyInfo> *p_list) const {
@@ -303,7 +532,7 @@ void Spine::_get_property_list(List<PropertyInfo> *p_list) const {
 	for (int i = 0; i < names_array.size(); i++) {
 		names.push_back(names_array[i]);
 	}
-	if (runtime.is_valid()) {
+	if (res.is_valid()) {
 		names.sort();
 		names.push_front("[stop]");
 		String hint;
@@ -321,13 +550,13 @@ void Spine::_get_property_list(List<PropertyInfo> *p_list) const {
 
 	names.clear();
 	names_array.clear();
-	if (runtime.is_valid()) {
-		names_array = runtime->get_skin_names();
+	if (res.is_valid()) {
+		names_array = res->get_skin_names();
 	}
 	for (int i = 0; i < names_array.size(); i++) {
 		names.push_back(names_array[i]);
 	}
-	if (runtime.is_valid()) {
+	if (res.is_valid()) {
 		String hint;
 		for (List<String>::Element *E = names.front(); E; E = E->next()) {
 
@@ -348,7 +577,10 @@ void Spine::_notification(int p_what) {
 	switch (p_what) {
 		case NOTIFICATION_PREDELETE: {
 			emit_signal("predelete");
-		}
+			if (pool_runtime) {
+				_release_runtime();
+			}
+		} break;
 
 		case NOTIFICATION_ENTER_TREE: {
 
@@ -402,13 +634,15 @@ void Spine::set_resource(Ref<SpineResource> p_data) {
 	_spine_dispose(); // cleanup
 
 	res = p_data;
+	// skin ids belong to the previous skeleton
+	skin_loadout.clear();
 
 	if (res.is_null()) {
 		return;
 	}
 	
-	runtime = res->create_runtime();
-	runtime->connect("event", this, "emit_signal");
+	// the runtime is created on first draw or use
+	update();
 
 	// if (res.is_null())
 	// 	return;
@@ -425,13 +659,6 @@ void Spine::set_resource(Ref<SpineResource> p_data) {
 
 	// _update_verties_count();
 
-	if (skin != "")
-		set_skin(skin);
-	if (current_animation != "[stop]")
-		play(current_animation, 1, loop);
-	else
-		reset();
-
 	_change_notify();
 }
 
@@ -440,32 +667,25 @@ Ref<SpineResource> Spine::get_resource() {
 }
 
 Array Spine::get_animation_names() const {
-	if (runtime.is_valid()) {
-		return runtime->get_animation_names();
-	} else {
-		return Array();
-	}
+	return res.is_valid() ? res->get_animation_names() : Array();
 }
 
 bool Spine::has_animation(const String &p_name) {
-	if (runtime.is_valid()) {
-		return runtime->has_animation(p_name);
-	} else {
-		return false;
-	}
+	return res.is_valid() && res->find_animation_id(p_name) >= 0;
 }
 
 void Spine::mix(const String &p_from, const String &p_to, real_t p_duration) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		runtime->mix(p_from, p_to, p_duration);
 	}
 }
 
 bool Spine::play(const String &p_name, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		if (!runtime->play(p_name, p_cunstom_scale, p_loop, p_track, p_delay)){
 			return false;
 		}
+		_dispatch_events();
 	}
 	
 	current_animation = p_name;
@@ -482,8 +702,28 @@ bool Spine::play(const String &p_name, real_t p_cunstom_scale, bool p_loop, int
 	return true;
 }
 
+bool Spine::play_id(int p_animation_id, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
+	if (!_ensure_runtime() || !runtime->play_id(p_animation_id, p_cunstom_scale, p_loop, p_track, p_delay)) {
+		return false;
+	}
+	_dispatch_events();
+
+	current_animation = res->animation_names[p_animation_id];
+	if (skip_frames) {
+		frames_to_skip = 0;
+	}
+
+	_set_process(true);
+	playing = true;
+	// update frame
+	if (!is_active())
+		_animation_process(0);
+
+	return true;
+}
+
 void Spine::set_animation_state(int p_track, String p_animation, float p_pos) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		runtime->set_animation_state(p_track, p_animation, p_pos);
 		queue_process();
 	}
@@ -491,7 +731,8 @@ void Spine::set_animation_state(int p_track, String p_animation, float p_pos) {
 
 bool Spine::add(const String &p_name, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
 
-	if (runtime.is_valid() && runtime->add(p_name, p_cunstom_scale, p_loop, p_track, p_delay)) {
+	if (_ensure_runtime() && runtime->add(p_name, p_cunstom_scale, p_loop, p_track, p_delay)) {
+		_dispatch_events();
 		_set_process(true);
 		playing = true;
 		return true;
@@ -501,9 +742,22 @@ bool Spine::add(const String &p_name, real_t p_cunstom_scale, bool p_loop, int p
 	
 }
 
+bool Spine::add_id(int p_animation_id, real_t p_cunstom_scale, bool p_loop, int p_track, float p_delay) {
+
+	if (_ensure_runtime() && runtime->add_id(p_animation_id, p_cunstom_scale, p_loop, p_track, p_delay)) {
+		_dispatch_events();
+		_set_process(true);
+		playing = true;
+		return true;
+	} else {
+		return false;
+	}
+}
+
 void Spine::clear(int p_track) {
 	if (runtime.is_valid()) {
 		runtime->clear();
+		_dispatch_events();
 	}
 }
 
@@ -542,8 +796,8 @@ int Spine::get_skip_frames() const {
 }
 
 String Spine::get_current_animation(int p_track) const {
-	if (runtime.is_valid()) {
-		return runtime->get_current_animation();
+	if (const_cast<Spine *>(this)->_ensure_runtime()) {
+		return runtime->get_current_animation(p_track);
 	} else {
 		return String();
 	}
@@ -559,11 +813,12 @@ void Spine::stop_all() {
 void Spine::reset() {
 	if (runtime.is_valid()) {
 		runtime->reset();
+		_dispatch_events();
 	}
 }
 
 void Spine::seek(int track, float p_pos) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		runtime->seek(track, p_pos);
 	}
 }
@@ -653,15 +908,34 @@ bool Spine::is_flip_y() const {
 }
 
 bool Spine::set_skin(const String &p_name) {
-	if (runtime.is_valid() && p_name.length() > 0) {
-		return runtime->set_skin(p_name);
+	if (_ensure_runtime() && p_name.length() > 0 && runtime->set_skin(p_name)) {
+		skin_loadout.clear();
+		return true;
 	} else {
 		return false;
 	}
 }
 
+bool Spine::set_skins(const Array &p_skins, bool p_bake) {
+	if (!_ensure_runtime()) {
+		return false;
+	}
+	Vector<int> ids;
+	for (int i = 0; i < p_skins.size(); i++) {
+		int id = p_skins[i].get_type() == Variant::INT ? (int)p_skins[i] : res->find_skin_id(p_skins[i]);
+		ERR_FAIL_COND_V_MSG(id < 0, false, "Skin not found: " + String(p_skins[i]));
+		ids.push_back(id);
+	}
+	if (!runtime->set_skins(ids, p_bake)) {
+		return false;
+	}
+	skin_loadout = ids;
+	skin_loadout_baked = p_bake;
+	return true;
+}
+
 Dictionary Spine::get_skeleton() const {
-	if (runtime.is_valid()) {
+	if (const_cast<Spine *>(this)->_ensure_runtime()) {
 		return runtime->get_skeleton(individual_textures);
 	} else {
 		return Dictionary();
@@ -669,7 +943,7 @@ Dictionary Spine::get_skeleton() const {
 }
 
 Dictionary Spine::get_attachment(const String &p_slot_name, const String &p_attachment_name) const {
-	if (runtime.is_valid()) {
+	if (const_cast<Spine *>(this)->_ensure_runtime()) {
 		return runtime->get_attachment(p_slot_name, p_attachment_name);
 	} else {
 		return Dictionary();
@@ -677,7 +951,7 @@ Dictionary Spine::get_attachment(const String &p_slot_name, const String &p_atta
 }
 
 Dictionary Spine::get_bone(const String &p_bone_name) const {
-	if (runtime.is_valid()) {
+	if (const_cast<Spine *>(this)->_ensure_runtime()) {
 		return runtime->get_bone(p_bone_name);
 	} else {
 		return Dictionary();
@@ -685,7 +959,7 @@ Dictionary Spine::get_bone(const String &p_bone_name) const {
 }
 
 Dictionary Spine::get_slot(const String &p_slot_name) const {
-	if (runtime.is_valid()) {
+	if (const_cast<Spine *>(this)->_ensure_runtime()) {
 		return runtime->get_slot(p_slot_name);
 	} else {
 		return Dictionary();
@@ -693,15 +967,48 @@ Dictionary Spine::get_slot(const String &p_slot_name) const {
 }
 
 bool Spine::set_attachment(const String &p_slot_name, const Variant &p_attachment) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		return runtime->set_attachment(p_slot_name, p_attachment);
 	} else {
 		return false;
 	}
 }
 
+int Spine::find_bone_id(const StringName &p_name) const {
+	return res.is_valid() ? res->find_bone_id(p_name) : -1;
+}
+
+int Spine::find_slot_id(const StringName &p_name) const {
+	return res.is_valid() ? res->find_slot_id(p_name) : -1;
+}
+
+int Spine::find_animation_id(const StringName &p_name) const {
+	return res.is_valid() ? res->find_animation_id(p_name) : -1;
+}
+
+int Spine::find_skin_id(const StringName &p_name) const {
+	return res.is_valid() ? res->find_skin_id(p_name) : -1;
+}
+
+Transform2D Spine::get_bone_world_by_id(int p_bone_id) const {
+	if (const_cast<Spine *>(this)->_ensure_runtime()) {
+		return runtime->get_bone_world_by_id(p_bone_id);
+	} else {
+		return Transform2D();
+	}
+}
+
+bool Spine::set_bones_local(const PoolIntArray &p_bone_ids, const PoolVector2Array &p_positions, const PoolRealArray &p_rotations) {
+	if (_ensure_runtime() && runtime->set_bones_local(p_bone_ids, p_positions, p_rotations)) {
+		update();
+		return true;
+	} else {
+		return false;
+	}
+}
+
 bool Spine::has_attachment_node(const String &p_bone_name, const Variant &p_node) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		return runtime->has_attachment_node(p_bone_name, p_node);
 	} else {
 		return false;
@@ -709,7 +1016,7 @@ bool Spine::has_attachment_node(const String &p_bone_name, const Variant &p_node
 }
 
 bool Spine::add_attachment_node(const String &p_bone_name, const Variant &p_node, const Vector2 &p_ofs, const Vector2 &p_scale, const real_t p_rot) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		return runtime->add_attachment_node(p_bone_name, p_node, p_ofs, p_scale, p_rot);
 	} else  {
 		return false;
@@ -752,7 +1059,7 @@ bool Spine::add_attachment_node(const String &p_bone_name, const Variant &p_node
 }
 
 bool Spine::remove_attachment_node(const String &p_bone_name, const Variant &p_node) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		return runtime->remove_attachment_node(p_bone_name, p_node);
 	} else {
 		return false;
@@ -779,7 +1086,7 @@ bool Spine::remove_attachment_node(const String &p_bone_name, const Variant &p_n
 }
 
 Ref<Shape2D> Spine::get_bounding_box(const String &p_slot_name, const String &p_attachment_name) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		return runtime->get_bounding_box(p_slot_name, p_attachment_name);
 	} else {
 		return Ref<Shape2D>();
@@ -802,7 +1109,7 @@ Ref<Shape2D> Spine::get_bounding_box(const String &p_slot_name, const String &p_
 }
 
 bool Spine::add_bounding_box(const String &p_bone_name, const String &p_slot_name, const String &p_attachment_name, const Variant &p_node, const Vector2 &p_ofs, const Vector2 &p_scale, const real_t p_rot) {
-	if (runtime.is_valid()) {
+	if (_ensure_runtime()) {
 		return runtime->add_bounding_box(p_bone_name, p_slot_name, p_attachment_name, p_node, p_ofs, p_scale, p_rot);
 	} else {
 		return false;
@@ -915,11 +1222,13 @@ void Spine::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("mix", "from", "to", "duration"), &Spine::mix, 0);
 	ClassDB::bind_method(D_METHOD("play", "name", "cunstom_scale", "loop", "track", "delay"), &Spine::play, 1.0f, false, 0, 0);
 	ClassDB::bind_method(D_METHOD("add", "name", "cunstom_scale", "loop", "track", "delay"), &Spine::add, 1.0f, false, 0, 0);
+	ClassDB::bind_method(D_METHOD("play_id", "animation_id", "cunstom_scale", "loop", "track", "delay"), &Spine::play_id, 1.0f, false, 0, 0);
+	ClassDB::bind_method(D_METHOD("add_id", "animation_id", "cunstom_scale", "loop", "track", "delay"), &Spine::add_id, 1.0f, false, 0, 0);
 	ClassDB::bind_method(D_METHOD("clear", "track"), &Spine::clear);
 	ClassDB::bind_method(D_METHOD("stop"), &Spine::stop);
 	ClassDB::bind_method(D_METHOD("is_playing", "track"), &Spine::is_playing);
 
-	ClassDB::bind_method(D_METHOD("get_current_animation"), &Spine::get_current_animation);
+	ClassDB::bind_method(D_METHOD("get_current_animation", "track"), &Spine::get_current_animation, DEFVAL(0));
 	ClassDB::bind_method(D_METHOD("stop_all"), &Spine::stop_all);
 	ClassDB::bind_method(D_METHOD("reset"), &Spine::reset);
 	ClassDB::bind_method(D_METHOD("seek", "track", "pos"), &Spine::seek);
@@ -938,6 +1247,7 @@ void Spine::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_flip_y", "fliped"), &Spine::set_flip_y);
 	ClassDB::bind_method(D_METHOD("is_flip_y"), &Spine::is_flip_y);
 	ClassDB::bind_method(D_METHOD("set_skin", "skin"), &Spine::set_skin);
+	ClassDB::bind_method(D_METHOD("set_skins", "skins", "bake"), &Spine::set_skins, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("set_animation_process_mode", "mode"), &Spine::set_animation_process_mode);
 	ClassDB::bind_method(D_METHOD("get_animation_process_mode"), &Spine::get_animation_process_mode);
 	ClassDB::bind_method(D_METHOD("get_skeleton"), &Spine::get_skeleton);
@@ -945,6 +1255,12 @@ void Spine::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_bone", "bone_name"), &Spine::get_bone);
 	ClassDB::bind_method(D_METHOD("get_slot", "slot_name"), &Spine::get_slot);
 	ClassDB::bind_method(D_METHOD("set_attachment", "slot_name", "attachment"), &Spine::set_attachment);
+	ClassDB::bind_method(D_METHOD("find_bone_id", "name"), &Spine::find_bone_id);
+	ClassDB::bind_method(D_METHOD("find_slot_id", "name"), &Spine::find_slot_id);
+	ClassDB::bind_method(D_METHOD("find_animation_id", "name"), &Spine::find_animation_id);
+	ClassDB::bind_method(D_METHOD("find_skin_id", "name"), &Spine::find_skin_id);
+	ClassDB::bind_method(D_METHOD("get_bone_world_by_id", "bone_id"), &Spine::get_bone_world_by_id);
+	ClassDB::bind_method(D_METHOD("set_bones_local", "bone_ids", "positions", "rotations"), &Spine::set_bones_local);
 	ClassDB::bind_method(D_METHOD("has_attachment_node", "bone_name", "node"), &Spine::has_attachment_node);
 	ClassDB::bind_method(D_METHOD("add_attachment_node", "bone_name", "node", "ofs", "scale", "rot"), &Spine::add_attachment_node, Vector2(0, 0), Vector2(1, 1), 0);
 	ClassDB::bind_method(D_METHOD("remove_attachment_node", "p_bone_name", "node"), &Spine::remove_attachment_node);
@@ -962,12 +1278,22 @@ void Spine::_bind_methods() {
 
 	// ClassDB::bind_method(D_METHOD("_on_fx_draw"), &Spine::_on_fx_draw);
 	ClassDB::bind_method(D_METHOD("_animation_process"), &Spine::_animation_process);
+	ClassDB::bind_method(D_METHOD("_on_screen_entered"), &Spine::_on_screen_entered);
+	ClassDB::bind_method(D_METHOD("poll_events"), &Spine::poll_events);
+	ClassDB::bind_method(D_METHOD("get_memory_report"), &Spine::get_memory_report);
+	ClassDB::bind_method(D_METHOD("set_emit_event_signals", "enable"), &Spine::set_emit_event_signals);
+	ClassDB::bind_method(D_METHOD("set_pool_runtime", "enable"), &Spine::set_pool_runtime);
+	ClassDB::bind_method(D_METHOD("is_pool_runtime"), &Spine::is_pool_runtime);
+	ClassDB::bind_method(D_METHOD("despawn"), &Spine::despawn);
+	ClassDB::bind_method(D_METHOD("is_emitting_event_signals"), &Spine::is_emitting_event_signals);
 
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "process_mode", PROPERTY_HINT_ENUM, "Fixed,Idle"), "set_animation_process_mode", "get_animation_process_mode");
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "speed", PROPERTY_HINT_RANGE, "-64,64,0.01"), "set_speed", "get_speed");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "active"), "set_active", "is_active");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "skip_frames", PROPERTY_HINT_RANGE, "0, 100, 1"), "set_skip_frames", "get_skip_frames");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "debug_bones"), "set_debug_bones", "is_debug_bones");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "emit_event_signals"), "set_emit_event_signals", "is_emitting_event_signals");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "pool_runtime"), "set_pool_runtime", "is_pool_runtime");
 
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "flip_x"), "set_flip_x", "is_flip_x");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "individual_textures"), "set_individual_textures", "get_individual_textures");
@@ -988,6 +1314,11 @@ void Spine::_bind_methods() {
 	BIND_ENUM_CONSTANT(DEBUG_ATTACHMENT_MESH);
 	BIND_ENUM_CONSTANT(DEBUG_ATTACHMENT_SKINNED_MESH);
 	BIND_ENUM_CONSTANT(DEBUG_ATTACHMENT_BOUNDING_BOX);
+
+	BIND_ENUM_CONSTANT(ANIMATION_EVENT_START);
+	BIND_ENUM_CONSTANT(ANIMATION_EVENT_COMPLETE);
+	BIND_ENUM_CONSTANT(ANIMATION_EVENT_EVENT);
+	BIND_ENUM_CONSTANT(ANIMATION_EVENT_END);
 }
 
 /*
@@ -1083,10 +1414,12 @@ Spine::Spine()
 	debug_attachment_bounding_box = false;
 
 	skin = "";
+	skin_loadout_baked = false;
 	current_animation = "[stop]";
 	loop = true;
 	state_hash = "";
 	process_queued = false;
+	screen_notifier = NULL;
 
 	modulate = Color(1, 1, 1, 1);
 	flip_x = false;
@@ -1095,6 +1428,13 @@ Spine::Spine()
 
 	performance_triangles_drawn = 0;
 	performance_triangles_generated = 0;
+
+	emit_event_signals = false;
+	event_listeners = 0;
+	event_listeners_frame = UINT64_MAX;
+	pool_runtime = false;
+	event_signal_cursor = 0;
+	event_poll_cursor = 0;
 }
 
 Spine::~Spine() {
@@ -37,6 +37,40 @@
 #include "core/array.h"
 
 class CollisionObject2D;
+class VisibilityNotifier2D;
+
+// Names of the fixed dynamic properties and animation signals, interned
+// once so _set/_get and event dispatch never build Strings. Created and
+// freed by the module registration, like SceneStringNames.
+class SpineStringNames {
+
+	static SpineStringNames *singleton;
+	SpineStringNames();
+
+public:
+	static void create() { singleton = memnew(SpineStringNames); }
+	static void free() {
+		memdelete(singleton);
+		singleton = NULL;
+	}
+	_FORCE_INLINE_ static SpineStringNames *get_singleton() { return singleton; }
+
+	StringName animation_start;
+	StringName animation_complete;
+	StringName animation_event;
+	StringName animation_end;
+	StringName playback_play;
+	StringName playback_loop;
+	StringName playback_forward;
+	StringName playback_skin;
+	StringName debug_region;
+	StringName debug_mesh;
+	StringName debug_skinned_mesh;
+	StringName debug_bounding_box;
+	StringName performance_triangles_drawn;
+	StringName performance_triangles_generated;
+	StringName performance_draw_calls;
+};
 
 class Spine : public Node2D {
 
@@ -57,6 +91,14 @@ public:
 		DEBUG_ATTACHMENT_BOUNDING_BOX,
 
 	};
+	enum AnimationEventType {
+
+		ANIMATION_EVENT_START = SpineEventBuffer::EVENT_START,
+		ANIMATION_EVENT_COMPLETE = SpineEventBuffer::EVENT_COMPLETE,
+		ANIMATION_EVENT_EVENT = SpineEventBuffer::EVENT_EVENT,
+		ANIMATION_EVENT_END = SpineEventBuffer::EVENT_END,
+
+	};
 
 private:
 	Ref<SpineResource> res;
@@ -82,6 +124,9 @@ private:
 	String current_animation;
 	bool loop;
 	String skin;
+	// skin ids worn through set_skins(), reapplied to reacquired runtimes
+	Vector<int> skin_loadout;
+	bool skin_loadout_baked;
 	int performance_triangles_drawn;
 	int performance_triangles_generated;
 
@@ -98,6 +143,20 @@ private:
 	float current_pos;
 	String state_hash;
 	bool process_queued;
+	// watches the bounds of a node drawn before it came on screen, so the
+	// runtime is created when it scrolls into view
+	VisibilityNotifier2D *screen_notifier;
+
+	bool emit_event_signals;
+	// animation_* signals with connections, one bit per event type; looked
+	// up at most once per frame and only while events are pending
+	uint32_t event_listeners;
+	uint64_t event_listeners_frame;
+	uint64_t event_signal_cursor;
+	uint64_t event_poll_cursor;
+
+	// return the runtime to the resource pool when freed or despawned
+	bool pool_runtime;
 
 	// typedef struct AttachmentNode {
 	// 	List<AttachmentNode>::Element *E;
@@ -114,9 +173,16 @@ private:
 	// void _on_animation_state_event(int p_track, spEventType p_type, spEvent *p_event, int p_loop_count);
 
 	void _spine_dispose();
+	void _acquire_runtime();
+	bool _ensure_runtime();
+	void _release_runtime();
 	void _animation_process(float p_delta);
+	Rect2 _get_screen_bounds() const;
+	bool _is_on_screen() const;
+	void _on_screen_entered();
 	void _animation_draw();
 	void _set_process(bool p_process, bool p_force = false);
+	void _dispatch_events();
 	// void _on_fx_draw();
 	// void _update_verties_count();
 	// String build_state_hash();
@@ -145,6 +211,8 @@ public:
 
 	bool play(const String& p_name, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
 	bool add(const String& p_name, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
+	bool play_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
+	bool add_id(int p_animation_id, real_t p_cunstom_scale = 1.0f, bool p_loop = false, int p_track = 0, float p_delay = 0);
 	void clear(int p_track = -1);
 	void stop();
 	bool is_playing(int p_track = 0) const;
@@ -188,6 +256,10 @@ public:
 	* attachment is attached from the new skin. Returns false if the skin was not found.
 	* @param skin May be 0.*/
 	bool set_skin(const String& p_name);
+	/* Wears the combination of several skins, given by name or id (spine 3.8+). With p_bake the regions they use are
+	* copied into one texture so the skeleton draws in one call. Combinations are cached on the resource and shared by
+	* every instance wearing the same skins. */
+	bool set_skins(const Array& p_skins, bool p_bake = false);
 
 	//spAttachment* get_attachment(const char* slotName, const char* attachmentName) const;
 	Dictionary get_skeleton() const;
@@ -199,6 +271,15 @@ public:
 	Dictionary get_slot(const String& p_slot_name) const;
 	/* Returns false if the slot or attachment was not found. */
 	bool set_attachment(const String& p_slot_name, const Variant& p_attachment);
+	/* Resolve names to integer handles once, returns -1 if the name was not found. */
+	int find_bone_id(const StringName& p_name) const;
+	int find_slot_id(const StringName& p_name) const;
+	int find_animation_id(const StringName& p_name) const;
+	int find_skin_id(const StringName& p_name) const;
+	/* Bone world transform in node space. */
+	Transform2D get_bone_world_by_id(int p_bone_id) const;
+	/* Sets local position and rotation of bones by skeleton bone index, then updates world transforms once. */
+	bool set_bones_local(const PoolIntArray& p_bone_ids, const PoolVector2Array& p_positions, const PoolRealArray& p_rotations);
 	// bind node to bone, auto update pos/rotate/scale
 	bool has_attachment_node(const String& p_bone_name, const Variant& p_node);
 	bool add_attachment_node(const String& p_bone_name, const Variant& p_node, const Vector2& p_ofs = Vector2(0, 0), const Vector2& p_scale = Vector2(1, 1), const real_t p_rot = 0);
@@ -212,6 +293,15 @@ public:
 	// void set_fx_slot_prefix(const String& p_prefix);
 	// String get_fx_slot_prefix() const;
 
+	// buffered animation events, see AnimationEventType
+	Dictionary poll_events();
+	Dictionary get_memory_report() const;
+	void set_emit_event_signals(bool p_enable);
+	bool is_emitting_event_signals() const;
+	void set_pool_runtime(bool p_enable);
+	bool is_pool_runtime() const;
+	void despawn();
+
 	void set_debug_bones(bool p_enable);
 	bool is_debug_bones() const;
 	void set_debug_attachment(DebugAttachmentMode p_mode, bool p_enable);
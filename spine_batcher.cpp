@@ -29,42 +29,55 @@
  *****************************************************************************/
 #include "spine_batcher.h"
 
-#define BATCH_CAPACITY 1024
+// 2D meshes switch to 32 bit indices above this, keep commands below it
+#define BATCH_CAPACITY 65535
 
 SpineBatcher::DrawCommand::DrawCommand() {
-	vertices = memnew_arr(Vector2, BATCH_CAPACITY);
-	colors = memnew_arr(Color, BATCH_CAPACITY);
-	uvs = memnew_arr(Vector2, BATCH_CAPACITY);
-	indies = memnew_arr(int, BATCH_CAPACITY * 3);
 	vertices_count = 0;
 	indies_count = 0;
+	pool_idx = 0;
 	mesh = VisualServer::get_singleton()->mesh_create();
 };
 
 SpineBatcher::DrawCommand::~DrawCommand() {
-	memdelete_arr(vertices);
-	memdelete_arr(colors);
-	memdelete_arr(uvs);
-	memdelete_arr(indies);
 	VisualServer::get_singleton()->free(mesh);
 }
 
+void SpineBatcher::DrawCommand::reserve(int p_vertices, int p_indies) {
+	if (vertices.size() < p_vertices) {
+		int size = next_power_of_2(p_vertices);
+		vertices.resize(size);
+		colors.resize(size);
+		uvs.resize(size);
+	}
+	if (indies.size() < p_indies) {
+		indies.resize(next_power_of_2(p_indies));
+	}
+}
+
+void SpineBatcher::DrawCommand::clear() {
+	VisualServer::get_singleton()->mesh_clear(mesh);
+	texture = Ref<Texture>();
+	vertices_count = 0;
+	indies_count = 0;
+}
+
 void SpineBatcher::DrawCommand::draw(RID ci) {
-	Vector<int> p_indices;
+	PoolIntArray p_indices;
 	p_indices.resize(indies_count);
-	memcpy(p_indices.ptrw(), indies, indies_count * sizeof(int) );
+	memcpy(p_indices.write().ptr(), indies.ptr(), indies_count * sizeof(int));
 
-	Vector<Vector2> p_points;
+	PoolVector2Array p_points;
 	p_points.resize(vertices_count);
-	memcpy(p_points.ptrw(), vertices, vertices_count * sizeof(Vector2));
+	memcpy(p_points.write().ptr(), vertices.ptr(), vertices_count * sizeof(Vector2));
 
-	Vector<Color> p_colors;
+	PoolColorArray p_colors;
 	p_colors.resize(vertices_count);
-	memcpy(p_colors.ptrw(), colors, vertices_count * sizeof(Color));
+	memcpy(p_colors.write().ptr(), colors.ptr(), vertices_count * sizeof(Color));
 
-	Vector<Vector2> p_uvs;
+	PoolVector2Array p_uvs;
 	p_uvs.resize(vertices_count);
-	memcpy(p_uvs.ptrw(), uvs, vertices_count * sizeof(Vector2));
+	memcpy(p_uvs.write().ptr(), uvs.ptr(), vertices_count * sizeof(Vector2));
 
 	Array arrays;
 	arrays.resize(Mesh::ARRAY_MAX);
@@ -81,6 +94,10 @@ void SpineBatcher::DrawCommand::draw(RID ci) {
 	VisualServer::get_singleton()->canvas_item_add_mesh(ci, mesh, Transform2D(), Color(1,1,1), texture->get_rid());
 }
 
+int SpineBatcher::DrawCommand::get_memory_usage() const {
+	return vertices.size() * (sizeof(Vector2) * 2 + sizeof(Color)) + indies.size() * sizeof(int);
+}
+
 
 void SpineBatcher::add(Ref<Texture> p_texture,
 	const float* p_vertices, const float* p_uvs, int p_vertices_count,
@@ -88,22 +105,26 @@ void SpineBatcher::add(Ref<Texture> p_texture,
 	Color *p_color, bool flip_x, bool flip_y, int index_item) {
 
 	if (p_texture != command->texture
-		|| command->vertices_count + (p_vertices_count >> 1) > BATCH_CAPACITY
-		|| command->indies_count + p_indies_count > BATCH_CAPACITY * 3) {
+		|| command->vertices_count + (p_vertices_count >> 1) > BATCH_CAPACITY) {
 
 		push_command();
 		command->texture = p_texture;
 	}
+	command->reserve(command->vertices_count + (p_vertices_count >> 1), command->indies_count + p_indies_count);
 
+	int *indies = command->indies.ptrw();
 	for (int i = 0; i < p_indies_count; ++i, ++command->indies_count)
-		command->indies[command->indies_count] = p_indies[i] + command->vertices_count;
+		indies[command->indies_count] = p_indies[i] + command->vertices_count;
 
+	Vector2 *vertices = command->vertices.ptrw();
+	Color *colors = command->colors.ptrw();
+	Vector2 *uvs = command->uvs.ptrw();
 	for (int i = 0; i < p_vertices_count; i += 2, ++command->vertices_count) {
-		command->vertices[command->vertices_count].x = flip_x ? -p_vertices[i] : p_vertices[i];
-		command->vertices[command->vertices_count].y = flip_y ? p_vertices[i + 1] : -p_vertices[i + 1];
-		command->colors[command->vertices_count] = *p_color;
-		command->uvs[command->vertices_count].x = p_uvs[i] + index_item;
-		command->uvs[command->vertices_count].y = p_uvs[i + 1];
+		vertices[command->vertices_count].x = flip_x ? -p_vertices[i] : p_vertices[i];
+		vertices[command->vertices_count].y = flip_y ? p_vertices[i + 1] : -p_vertices[i + 1];
+		colors[command->vertices_count] = *p_color;
+		uvs[command->vertices_count].x = p_uvs[i] + index_item;
+		uvs[command->vertices_count].y = p_uvs[i + 1];
 	}
 }
 
@@ -118,6 +139,10 @@ int SpineBatcher::triangles_count() {
 	return count;
 }
 
+int SpineBatcher::draw_calls_count() const {
+	return drawed_list.size();
+}
+
 void SpineBatcher::flush() {
 
 	RID ci = owner->get_canvas_item();
@@ -141,17 +166,39 @@ void SpineBatcher::push_command() {
 }
 
 SpineBatcher::DrawCommand* SpineBatcher::create_command() {
+	if (free_list.front()) {
+		DrawCommand *e = free_list.front()->get();
+		free_list.pop_front();
+		return e;
+	}
 	return memnew(SpineBatcher::DrawCommand);
 }
 
 void SpineBatcher::reset() {
 	for (List<DrawCommand*>::Element *E = drawed_list.front(); E; E = E->next()) {
 		DrawCommand *e = E->get();
-		memdelete(e);
+		e->clear();
+		free_list.push_back(e);
 	}
 	drawed_list.clear();
 }
 
+Dictionary SpineBatcher::get_memory_report() const {
+	int commands = 1;
+	int bytes = command->get_memory_usage();
+	const List<DrawCommand *> *lists[] = { &command_list, &drawed_list, &free_list };
+	for (int i = 0; i < 3; i++) {
+		for (const List<DrawCommand *>::Element *E = lists[i]->front(); E; E = E->next()) {
+			bytes += E->get()->get_memory_usage();
+			commands++;
+		}
+	}
+	Dictionary report;
+	report["commands"] = commands;
+	report["bytes"] = bytes;
+	return report;
+}
+
 SpineBatcher::SpineBatcher(Node2D *owner) : owner(owner) {
 	command = create_command();
 }
@@ -172,5 +219,12 @@ SpineBatcher::~SpineBatcher() {
 	}
 	drawed_list.clear();
 
+	for (List<DrawCommand*>::Element *E = free_list.front(); E; E = E->next()) {
+
+		DrawCommand *e = E->get();
+		memdelete(e);
+	}
+	free_list.clear();
+
 	memdelete(command);
 }
@@ -37,6 +37,9 @@ class SpineBatcher {
 	Node2D *owner;
 
 
+	// Buffers grow to the largest batch the owner has drawn and are kept
+	// for reuse together with the mesh, so idle instances hold only what
+	// their skeleton actually needs.
 	struct DrawCommand {
 		DrawCommand();
 		~DrawCommand();
@@ -45,19 +48,23 @@ class SpineBatcher {
 		RID mesh;
 		int vertices_count;
 		int indies_count;
-		Vector2 *vertices;
-		Color *colors;
-		Vector2 *uvs;
-		int* indies;
+		Vector<Vector2> vertices;
+		Vector<Color> colors;
+		Vector<Vector2> uvs;
+		Vector<int> indies;
 		int pool_idx;
 
+		void reserve(int p_vertices, int p_indies);
+		void clear();
 		void draw(RID ci);
+		int get_memory_usage() const;
 	};
 
 	DrawCommand *command;
 
 	List<DrawCommand *> command_list;
 	List<DrawCommand *> drawed_list;
+	List<DrawCommand *> free_list;
 
 	void push_command();
 	SpineBatcher::DrawCommand* create_command();
@@ -74,6 +81,9 @@ public:
 
 	void flush();
 	int triangles_count();
+	// draw calls issued by the last flush; one per texture switch
+	int draw_calls_count() const;
+	Dictionary get_memory_report() const;
 
 	SpineBatcher(Node2D *owner);
 	~SpineBatcher();
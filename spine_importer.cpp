@@ -0,0 +1,84 @@
+#ifdef TOOLS_ENABLED
+
+#include "spine_importer.h"
+#include "core/os/file_access.h"
+#include "runtime/spine_runtime.h"
+
+String ResourceImporterSpine::get_importer_name() const {
+	return "spine";
+}
+
+String ResourceImporterSpine::get_visible_name() const {
+	return "Spine Skeleton";
+}
+
+void ResourceImporterSpine::get_recognized_extensions(List<String> *p_extensions) const {
+	// plain .json is left alone, most json files of a project aren't skeletons
+	p_extensions->push_back("spjson");
+	p_extensions->push_back("skel");
+}
+
+String ResourceImporterSpine::get_save_extension() const {
+	return "spinec";
+}
+
+String ResourceImporterSpine::get_resource_type() const {
+	return "SpineResource";
+}
+
+int ResourceImporterSpine::get_preset_count() const {
+	return 0;
+}
+
+String ResourceImporterSpine::get_preset_name(int p_idx) const {
+	return String();
+}
+
+void ResourceImporterSpine::get_import_options(List<ImportOption> *r_options, int p_preset) const {
+	r_options->push_back(ImportOption(PropertyInfo(Variant::BOOL, "atlas/merge_pages"), false));
+	r_options->push_back(ImportOption(PropertyInfo(Variant::INT, "atlas/max_page_size", PROPERTY_HINT_RANGE, "256,16384,1"), 4096));
+}
+
+bool ResourceImporterSpine::get_option_visibility(const String &p_option, const Map<StringName, Variant> &p_options) const {
+	if (p_option == "atlas/max_page_size") {
+		return p_options["atlas/merge_pages"];
+	}
+	return true;
+}
+
+Error ResourceImporterSpine::import(const String &p_source_file, const String &p_save_path, const Map<StringName, Variant> &p_options, List<String> *r_platform_variants, List<String> *r_gen_files, Variant *r_metadata) {
+	SpineRuntime::SkeletonSource source;
+	Error err = SpineRuntime::read_skeleton(p_source_file, source);
+	if (err != OK) {
+		return err;
+	}
+	ERR_FAIL_COND_V_MSG(source.version.empty(), ERR_FILE_UNRECOGNIZED, "Not a spine skeleton: " + p_source_file);
+	if (p_options["atlas/merge_pages"]) {
+		err = SpineRuntime::merge_atlas_pages(source, p_options["atlas/max_page_size"], p_save_path + "_merged", r_gen_files);
+		if (err != OK) {
+			return err;
+		}
+	}
+	err = SpineRuntime::save_cooked(p_save_path + "." + get_save_extension(), source);
+	if (err == OK && r_metadata) {
+		Dictionary metadata;
+		metadata["atlas_path"] = source.atlas_path;
+		metadata["atlas_modified_time"] = FileAccess::get_modified_time(source.atlas_path);
+		metadata["format"] = SpineRuntime::get_cooked_format_version();
+		*r_metadata = metadata;
+	}
+	return err;
+}
+
+// The atlas is cooked into the .spinec, so a newer atlas makes the import
+// stale, as does an older cooked format.
+bool ResourceImporterSpine::are_import_settings_valid(const String &p_path) const {
+	Dictionary metadata = ResourceFormatImporter::get_singleton()->get_resource_metadata(p_path);
+	if (!metadata.has("atlas_path") || (int)metadata.get("format", 0) != SpineRuntime::get_cooked_format_version()) {
+		return false;
+	}
+	String atlas_path = metadata["atlas_path"];
+	return FileAccess::exists(atlas_path) && FileAccess::get_modified_time(atlas_path) == (uint64_t)metadata["atlas_modified_time"];
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SPINE_IMPORTER_H
+#define SPINE_IMPORTER_H
+
+#ifdef TOOLS_ENABLED
+
+#include "core/io/resource_importer.h"
+
+// Cooks .spjson/.skel exports and their atlas into a single .spinec file, see
+// SpineRuntime::save_cooked(). The atlas pages and regions are cooked into a
+// table the 3.6 and 4.x runtimes build their atlas from without parsing its
+// text; the skeleton is stored minified and still parsed on load.
+class ResourceImporterSpine : public ResourceImporter {
+	GDCLASS(ResourceImporterSpine, ResourceImporter);
+
+public:
+	virtual String get_importer_name() const;
+	virtual String get_visible_name() const;
+	virtual void get_recognized_extensions(List<String> *p_extensions) const;
+	virtual String get_save_extension() const;
+	virtual String get_resource_type() const;
+
+	virtual int get_preset_count() const;
+	virtual String get_preset_name(int p_idx) const;
+
+	virtual void get_import_options(List<ImportOption> *r_options, int p_preset = 0) const;
+	virtual bool get_option_visibility(const String &p_option, const Map<StringName, Variant> &p_options) const;
+
+	virtual bool are_import_settings_valid(const String &p_path) const;
+
+	virtual Error import(const String &p_source_file, const String &p_save_path, const Map<StringName, Variant> &p_options, List<String> *r_platform_variants, List<String> *r_gen_files = NULL, Variant *r_metadata = NULL);
+};
+
+#endif
+
+#endif